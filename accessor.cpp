@@ -0,0 +1,80 @@
+#include "accessor.h"
+
+#include "basic_property.h"
+#include "numeric_property.h"
+
+namespace property
+{
+
+const Property& resolve(const GroupProperty& root, const std::string& path)
+{
+    const GroupProperty* group = &root;
+    size_t begin = 0;
+    while (true) {
+        const size_t end = path.find('.', begin);
+        const std::string name = path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        const Property& child = group->get<Property>(name);
+        if (end == std::string::npos)
+            return child;
+        group = &child.cast<GroupProperty>();
+        begin = end + 1;
+    }
+}
+
+Property& resolveWritable(GroupProperty& root, const std::string& path)
+{
+    const GroupProperty* group = &root;
+    size_t begin = 0;
+    while (true) {
+        if (!group->writable())
+            throw std::invalid_argument("Cannot write through the read-only group " + group->name());
+        const size_t end = path.find('.', begin);
+        const std::string name = path.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        const Property& child = group->get<Property>(name);
+        // Groups only hand out const children, but the ones below a non-const writable root are not const objects
+        if (end == std::string::npos)
+            return const_cast<Property&>(child);
+        group = &child.cast<GroupProperty>();
+        begin = end + 1;
+    }
+}
+
+namespace
+{
+
+template <class T>
+bool assignAs(Property& target, const Property& source)
+{
+    T* cast = dynamic_cast<T*>(&target);
+    if (cast)
+        *cast = source.cast<T>();
+    return cast;
+}
+
+template <class T>
+bool assignableAs(const Property& target, const Property& source)
+{
+    return dynamic_cast<const T*>(&target) && dynamic_cast<const T*>(&source);
+}
+}
+
+void assign(Property& target, const Property& source)
+{
+    if (!assignAs<BooleanProperty>(target, source) && !assignAs<StringProperty>(target, source) &&
+        !assignAs<WStringProperty>(target, source) && !assignAs<IntProperty>(target, source) &&
+        !assignAs<DoubleProperty>(target, source))
+        throw std::invalid_argument("Cannot assign a property of type " + target.id());
+}
+
+void assign(GroupProperty& root, const std::string& path, const Property& source)
+{
+    assign(resolveWritable(root, path), source);
+}
+
+bool assignable(const Property& target, const Property& source)
+{
+    return assignableAs<BooleanProperty>(target, source) || assignableAs<StringProperty>(target, source) ||
+           assignableAs<WStringProperty>(target, source) || assignableAs<IntProperty>(target, source) ||
+           assignableAs<DoubleProperty>(target, source);
+}
+}
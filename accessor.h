@@ -0,0 +1,47 @@
+#pragma once
+
+#include "group_property.h"
+#include "properties_export.h"
+
+namespace property
+{
+
+/// Resolves a dotted path such as "motor.limits.max" below a group. Throws std::out_of_range if a step is missing
+/// and std::bad_cast if an intermediate step is not a group.
+PROPERTIES_EXPORT const Property& resolve(const GroupProperty& root, const std::string& path);
+
+/// As resolve, for writing: throws std::invalid_argument if the root or an intermediate group is not writable()
+PROPERTIES_EXPORT Property& resolveWritable(GroupProperty& root, const std::string& path);
+
+/// Assigns the value of source to target, both being of the same type, as their operator= would. Throws
+/// std::bad_cast if the types differ and std::invalid_argument for groups.
+PROPERTIES_EXPORT void assign(Property& target, const Property& source);
+/// Assigns the value of source to the property at the dotted path below root
+PROPERTIES_EXPORT void assign(GroupProperty& root, const std::string& path, const Property& source);
+/// Whether assign(target, source) would assign the value rather than throw
+PROPERTIES_EXPORT bool assignable(const Property& target, const Property& source);
+
+/// Typed handle on a property resolved once from a dotted path: reads and writes then go straight to the property,
+/// without any lookup or cast. The handle stays valid for as long as the shape of the tree is unchanged.
+template <class T>
+class Accessor
+{
+public:
+    using value_type = typename T::value_type;
+
+    Accessor(GroupProperty& root, const std::string& path) : prop_{&resolveWritable(root, path).cast<T>()} {}
+
+    /// Assigns through the property's own operator, hence with its checks (e.g. numeric bounds)
+    Accessor& operator=(const value_type& value)
+    {
+        *prop_ = value;
+        return *this;
+    }
+
+    decltype(auto) value() const { return prop_->value(); }
+    const T& property() const { return *prop_; }
+
+private:
+    T* prop_;
+};
+}
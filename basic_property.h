@@ -17,8 +17,18 @@ public:
         : Property(name, displayName), value_{value}
     {
     }
+    /// Shares the descriptor of rhs when the name and display name are the same
     BasicProperty(const std::string& name, const BasicProperty& rhs, const std::string& displayName = "")
-        : BasicProperty(name, rhs.value(), displayName.empty() ? rhs.displayName() : displayName)
+        : BasicProperty(name == rhs.name() && (displayName.empty() || displayName == rhs.displayName())
+                            ? rhs.descriptor()
+                            : std::make_shared<const Descriptor>(
+                                  name, displayName.empty() ? rhs.displayName() : displayName),
+                        rhs.value())
+    {
+    }
+    /// Property described by a descriptor shared with others, e.g. the instances of one field of a schema
+    BasicProperty(std::shared_ptr<const Descriptor> descriptor, const value_type& value)
+        : Property(std::move(descriptor)), value_{value}
     {
     }
     ~BasicProperty() override {}
@@ -27,11 +37,13 @@ public:
     BasicProperty& operator=(const BasicProperty& rhs)
     {
         value_ = rhs.value_;
+        changed();
         return *this;
     }
     BasicProperty& operator=(const value_type& value)
     {
         value_ = value;
+        changed();
         return *this;
     }
     bool operator==(const BasicProperty& rhs) const { return !operator!=(rhs); }
@@ -41,6 +53,12 @@ public:
 
     static const std::string identifier;
     const std::string& id() const override { return identifier; }
+    uint64_t fingerprint() const override { return fingerprint(Hashable<value_type>()); }
+    bool equals(const Property& rhs) const override
+    {
+        const BasicProperty* other = dynamic_cast<const BasicProperty*>(&rhs);
+        return other && *this == *other;
+    }
 
     const value_type& value() const { return value_; }
 
@@ -49,6 +67,16 @@ public:
         return BasicProperty(property.name(), property.cast<BasicProperty>().value(), property.displayName());
     }
 
+private:
+    uint64_t fingerprint(std::true_type) const { return header().add(value_).value(); }
+    /// Values which Hasher cannot hash (e.g. enumerations) are hashed in their string form
+    uint64_t fingerprint(std::false_type) const
+    {
+        std::stringstream ss;
+        stream::convert(ss, value_);
+        return header().add(ss.str()).value();
+    }
+
 private:
     value_type value_;
 };
@@ -0,0 +1,157 @@
+#include "change_feed.h"
+
+#include "basic_property.h"
+#include "group_property.h"
+#include "numeric_property.h"
+
+#include <unordered_map>
+
+namespace property
+{
+
+struct ChangeFeed::Cell {
+    /// Position of the cell in the queue: equal to the enqueue position when free, one more once filled
+    std::atomic<size_t> sequence;
+    ChangeRecord record;
+};
+
+void publish(ChangeFeed& feed, const Property& prop)
+{
+    ChangeRecord record{&prop, 0, ChangeRecord::Kind::Other, {}};
+    if (const BooleanProperty* boolean = dynamic_cast<const BooleanProperty*>(&prop)) {
+        record.kind = ChangeRecord::Kind::Bool;
+        record.value.boolean = boolean->value();
+    } else if (const IntProperty* integer = dynamic_cast<const IntProperty*>(&prop)) {
+        record.kind = ChangeRecord::Kind::Int;
+        record.value.integer = integer->value();
+    } else if (const DoubleProperty* real = dynamic_cast<const DoubleProperty*>(&prop)) {
+        record.kind = ChangeRecord::Kind::Double;
+        record.value.real = real->DoubleProperty::value();
+    }
+    feed.push(record);
+}
+
+void detach(ChangeFeed& feed, const Property& prop)
+{
+    std::lock_guard<std::mutex> lock(feed.watchedMutex_);
+    feed.watched_.erase(&prop);
+}
+
+ChangeFeed::ChangeFeed(size_t capacity)
+    : mask_{[capacity]() {
+          size_t size = 1;
+          while (size < capacity)
+              size <<= 1;
+          return size - 1;
+      }()},
+      cells_{new Cell[mask_ + 1]}
+{
+    for (size_t i = 0; i <= mask_; ++i)
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+ChangeFeed::~ChangeFeed()
+{
+    std::lock_guard<std::mutex> lock(watchedMutex_);
+    for (const auto& watched : watched_)
+        watched.first->feed_.store(nullptr, std::memory_order_release);
+}
+
+void ChangeFeed::watch(const Property& prop)
+{
+    attach(prop, this);
+}
+
+void ChangeFeed::unwatch(const Property& prop)
+{
+    attach(prop, nullptr);
+}
+
+void ChangeFeed::attach(const Property& prop, ChangeFeed* feed)
+{
+    if (const GroupProperty* group = dynamic_cast<const GroupProperty*>(&prop)) {
+        for (const Property& child : *group)
+            attach(child, feed);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(watchedMutex_);
+    if (feed)
+        watched_[&prop] = enqueue_.load(std::memory_order_relaxed);
+    else
+        watched_.erase(&prop);
+    prop.feed_.store(feed, std::memory_order_release);
+}
+
+// Bounded multi-producer queue after Dmitry Vyukov's design: producers claim a position with a CAS and publish
+// the cell through its sequence number
+void ChangeFeed::push(const ChangeRecord& record)
+{
+    size_t pos = enqueue_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells_[pos & mask_];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - pos);
+        if (difference == 0) {
+            if (enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (difference < 0) {
+            overflowed_.store(true, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_.load(std::memory_order_relaxed);
+        }
+    }
+    cell->record = record;
+    cell->record.sequence = pos;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    // Only take the lock when the subscriber sleeps: it checks the queue again under the lock before waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pushed_.notify_one();
+    }
+}
+
+bool ChangeFeed::empty() const
+{
+    const size_t sequence = cells_[dequeue_ & mask_].sequence.load(std::memory_order_acquire);
+    return sequence != dequeue_ + 1;
+}
+
+bool ChangeFeed::poll(ChangeBatch& batch)
+{
+    batch.changes.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> watchedLock(watchedMutex_);
+    std::unordered_map<const Property*, size_t> positions;
+    while (!empty()) {
+        Cell& cell = cells_[dequeue_ & mask_];
+        auto watched = watched_.find(cell.record.property);
+        if (watched != watched_.end() && cell.record.sequence >= watched->second) {
+            auto inserted = positions.emplace(cell.record.property, batch.changes.size());
+            if (inserted.second)
+                batch.changes.push_back(cell.record);
+            else
+                batch.changes[inserted.first->second] = cell.record;
+        }
+        cell.sequence.store(dequeue_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_;
+    }
+    batch.overflowed = overflowed_.exchange(false, std::memory_order_relaxed);
+    return !batch.changes.empty() || batch.overflowed;
+}
+
+bool ChangeFeed::wait(ChangeBatch& batch, std::chrono::milliseconds timeout)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        pushed_.wait_for(lock, timeout, [this]() { return !empty() || overflowed_.load(std::memory_order_relaxed); });
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+    return poll(batch);
+}
+}
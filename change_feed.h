@@ -0,0 +1,92 @@
+#pragma once
+
+#include "properties_export.h"
+#include "property.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace property
+{
+
+/// Change of a watched property. Scalar values are captured when the change is made; for other types (strings),
+/// value is left unset and the property must be read under the caller's own synchronisation. The changes of a
+/// property which was unwatched or destroyed before the batch was taken are dropped.
+struct ChangeRecord {
+    enum class Kind : unsigned char { Bool, Int, Double, Other };
+
+    const Property* property;
+    /// Order of the changes within the feed
+    size_t sequence;
+    Kind kind;
+    union {
+        bool boolean;
+        long long integer;
+        double real;
+    } value;
+};
+
+struct ChangeBatch {
+    /// One record per property, with its latest value, in the order of their first change
+    std::vector<ChangeRecord> changes;
+    /// Changes were lost because the feed was full: watched properties must be read again
+    bool overflowed{false};
+};
+
+/// Collects the changes of the properties it watches. Assignments push compact records into a bounded lock-free
+/// queue, from any number of threads; a subscriber thread takes them in coalesced batches. Properties which are not
+/// watched pay a single null check per assignment.
+///
+/// A property can be watched by one feed at a time; destroying it unwatches it. A feed must not be destroyed while
+/// other threads destroy the properties it watches.
+class PROPERTIES_EXPORT ChangeFeed
+{
+public:
+    /// The capacity is rounded up to a power of two
+    explicit ChangeFeed(size_t capacity = 4096);
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+    /// Unwatches everything still watched
+    ~ChangeFeed();
+
+    /// Watches a property; for groups, all their current descendants
+    void watch(const Property& prop);
+    void unwatch(const Property& prop);
+
+    /// Takes the pending changes without blocking, returns false if there were none
+    bool poll(ChangeBatch& batch);
+    /// As poll, waiting up to timeout for a first change
+    bool wait(ChangeBatch& batch, std::chrono::milliseconds timeout);
+
+private:
+    friend void publish(ChangeFeed& feed, const Property& prop);
+    friend void detach(ChangeFeed& feed, const Property& prop);
+
+    struct Cell;
+
+    void push(const ChangeRecord& record);
+    bool empty() const;
+    void attach(const Property& prop, ChangeFeed* feed);
+
+private:
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    std::atomic<size_t> enqueue_{0};
+    std::atomic<bool> overflowed_{false};
+
+    /// Consumer side
+    std::mutex mutex_;
+    std::condition_variable pushed_;
+    std::atomic<bool> waiting_{false};
+    size_t dequeue_{0};
+
+    std::mutex watchedMutex_;
+    /// Watched properties, with the queue position from which their changes count: records of an earlier property
+    /// at the same address are older
+    std::unordered_map<const Property*, size_t> watched_;
+};
+}
@@ -0,0 +1,58 @@
+#include "diff.h"
+
+#include "group_property.h"
+
+#include <unordered_map>
+
+namespace property
+{
+
+namespace
+{
+
+std::string childPath(const std::string& path, const std::string& name)
+{
+    return path.empty() ? name : path + "." + name;
+}
+
+void diffInto(const Property& before, const Property& after, const std::string& path, std::vector<Change>& changes)
+{
+    if (before.fingerprint() == after.fingerprint())
+        return;
+
+    const GroupProperty* lhs = dynamic_cast<const GroupProperty*>(&before);
+    const GroupProperty* rhs = dynamic_cast<const GroupProperty*>(&after);
+    if (!lhs || !rhs || before.name() != after.name()) {
+        changes.push_back({Change::Kind::Modified, path});
+        return;
+    }
+
+    std::unordered_map<std::string, const Property*> removed;
+    removed.reserve(lhs->size());
+    for (const Property& child : *lhs)
+        removed.emplace(child.name(), &child);
+
+    for (const Property& child : *rhs) {
+        auto it = removed.find(child.name());
+        if (it == removed.end()) {
+            changes.push_back({Change::Kind::Added, childPath(path, child.name())});
+        } else {
+            diffInto(*it->second, child, childPath(path, child.name()), changes);
+            removed.erase(it);
+        }
+    }
+    // Keep the order of the original children
+    for (const Property& child : *lhs) {
+        if (removed.count(child.name()))
+            changes.push_back({Change::Kind::Removed, childPath(path, child.name())});
+    }
+}
+}
+
+std::vector<Change> diff(const Property& before, const Property& after)
+{
+    std::vector<Change> changes;
+    diffInto(before, after, "", changes);
+    return changes;
+}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "properties_export.h"
+#include "property.h"
+
+#include <vector>
+
+namespace property
+{
+
+struct Change {
+    enum class Kind { Added, Removed, Modified };
+
+    Kind kind;
+    /// Dotted path from the compared roots, empty for the roots themselves
+    std::string path;
+};
+
+/// Minimal list of changes turning before into after. Subtrees with equal fingerprints are skipped without being
+/// visited; display names are ignored, as for equality.
+PROPERTIES_EXPORT std::vector<Change> diff(const Property& before, const Property& after);
+}
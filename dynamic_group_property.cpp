@@ -0,0 +1,95 @@
+#include "dynamic_group_property.h"
+
+#include <algorithm>
+
+namespace property
+{
+
+constexpr size_t DynamicGroupProperty::inlineCapacity;
+
+DynamicGroupProperty::DynamicGroupProperty(const std::string& name, const std::string& displayName)
+    : GroupProperty(name, displayName)
+{
+}
+
+DynamicGroupProperty::~DynamicGroupProperty()
+{
+    const Property* const* children = data();
+    for (size_t i = 0; i < size_; ++i)
+        delete children[i];
+}
+
+GroupPropertyIterator DynamicGroupProperty::find(const std::string& name) const
+{
+    if (heap_.empty())
+        return GroupProperty::find(name);
+    auto it = index_.find(name);
+    return it != index_.end() ? GroupPropertyIterator{data(), it->second, size_} : end();
+}
+
+void DynamicGroupProperty::insertChild(size_t position, std::unique_ptr<Property> child)
+{
+    if (position > size_)
+        throw std::out_of_range("Cannot insert at " + std::to_string(position) + " in a group of " +
+                                std::to_string(size_));
+    if (find(child->name()) != end())
+        throw std::invalid_argument("There is already a child with name: " + child->name());
+
+    if (heap_.empty() && size_ == inlineCapacity) {
+        heap_.reserve(2 * inlineCapacity);
+        heap_.assign(inline_, inline_ + size_);
+        for (size_t i = 0; i < size_; ++i)
+            index_.emplace(inline_[i]->name(), i);
+    }
+    if (heap_.empty()) {
+        std::copy_backward(inline_ + position, inline_ + size_, inline_ + size_ + 1);
+        inline_[position] = child.get();
+    } else {
+        heap_.insert(heap_.begin() + position, child.get());
+        // Appending, the common case when building a group, shifts no position
+        if (position < size_) {
+            for (auto& entry : index_) {
+                if (entry.second >= position)
+                    ++entry.second;
+            }
+        }
+        index_.emplace(child->name(), position);
+    }
+    ++size_;
+    child.release();
+    restructured();
+}
+
+std::unique_ptr<Property> DynamicGroupProperty::remove(const std::string& name)
+{
+    auto it = find(name);
+    if (it == end())
+        throw std::out_of_range("No child with name: " + name);
+    const Property* const* children = data();
+    const size_t position = static_cast<size_t>(std::find(children, children + size_, &*it) - children);
+    std::unique_ptr<Property> child(const_cast<Property*>(children[position]));
+
+    if (heap_.empty()) {
+        std::copy(inline_ + position + 1, inline_ + size_, inline_ + position);
+    } else {
+        heap_.erase(heap_.begin() + position);
+        index_.erase(name);
+        if (position + 1 < size_) {
+            for (auto& entry : index_) {
+                if (entry.second > position)
+                    --entry.second;
+            }
+        }
+    }
+    --size_;
+    disown(*child);
+    restructured();
+    return child;
+}
+
+void DynamicGroupProperty::restructured()
+{
+    if (invalidate())
+        changed();
+}
+}
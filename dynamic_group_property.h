@@ -0,0 +1,63 @@
+#pragma once
+
+#include "group_property.h"
+#include "properties_export.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace property
+{
+
+/// Group owning children which are inserted and removed at runtime. The pointers to the first inlineCapacity
+/// children are stored in the group itself, without allocating; larger groups move them to the heap and index
+/// their children by name.
+class PROPERTIES_EXPORT DynamicGroupProperty : public GroupProperty
+{
+public:
+    static constexpr size_t inlineCapacity = 8;
+
+    DynamicGroupProperty(const std::string& name, const std::string& displayName = "");
+    DynamicGroupProperty(const DynamicGroupProperty&) = delete;
+    DynamicGroupProperty& operator=(const DynamicGroupProperty&) = delete;
+    ~DynamicGroupProperty() override;
+
+    GroupPropertyIterator begin() const override { return GroupPropertyIterator{data(), 0, size_}; }
+    GroupPropertyIterator find(const std::string& name) const override;
+    GroupPropertyIterator end() const override { return GroupPropertyIterator{data(), size_, size_}; }
+    size_t size() const override { return size_; }
+
+    /// Appends a child and returns it. Throws std::invalid_argument if there is already a child with that name.
+    template <class T>
+    T& insert(std::unique_ptr<T> child)
+    {
+        return insert(size_, std::move(child));
+    }
+    /// Inserts a child before the given position (at most size()), and returns it
+    template <class T>
+    T& insert(size_t position, std::unique_ptr<T> child)
+    {
+        T& inserted = *child;
+        insertChild(position, std::unique_ptr<Property>(std::move(child)));
+        return inserted;
+    }
+    /// Removes the child with the given name and hands it back. Throws std::out_of_range if there is none.
+    std::unique_ptr<Property> remove(const std::string& name);
+
+private:
+    const Property* const* data() const { return heap_.empty() ? inline_ : heap_.data(); }
+    const Property** data() { return heap_.empty() ? inline_ : heap_.data(); }
+    void insertChild(size_t position, std::unique_ptr<Property> child);
+    /// Invalidates the cached state of this group and of the enclosing ones
+    void restructured();
+
+private:
+    const Property* inline_[inlineCapacity];
+    /// All the children once there are more than inlineCapacity of them
+    std::vector<const Property*> heap_;
+    size_t size_{0};
+    /// Positions by name, only kept while the children are on the heap
+    std::unordered_map<std::string, size_t> index_;
+};
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace property
+{
+
+/// Whether Hasher::add accepts values of type T
+template <class T>
+struct Hashable : std::is_arithmetic<T> {
+};
+template <class C>
+struct Hashable<std::basic_string<C>> : std::true_type {
+};
+
+/// Incremental 64-bit FNV-1a hash, stable across processes and platforms of the same endianness
+class Hasher
+{
+public:
+    Hasher& add(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            state_ ^= bytes[i];
+            state_ *= 1099511628211ull;
+        }
+        return *this;
+    }
+    template <class T>
+    Hasher& add(const T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "Only arithmetic values and strings can be hashed");
+        // Equal values must hash equally, including both zeros
+        const T normalised = value == T(0) ? T(0) : value;
+        return add(&normalised, sizeof(T));
+    }
+    template <class C>
+    Hasher& add(const std::basic_string<C>& value)
+    {
+        add(value.size());
+        return add(value.data(), value.size() * sizeof(C));
+    }
+
+    uint64_t value() const { return state_; }
+
+private:
+    uint64_t state_{14695981039346656037ull};
+};
+}
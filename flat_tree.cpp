@@ -0,0 +1,100 @@
+#include "flat_tree.h"
+
+#include "basic_property.h"
+#include "group_property.h"
+#include "numeric_property.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace property
+{
+
+namespace
+{
+
+constexpr double infinity = std::numeric_limits<double>::infinity();
+
+void flattenInto(const Property& prop, const std::string& path, uint32_t parent, FlatTree& tree)
+{
+    const uint32_t row = static_cast<uint32_t>(tree.size());
+    FlatTree::Kind kind = FlatTree::Kind::Other;
+    double value = 0.;
+    double min = -infinity;
+    double max = infinity;
+
+    const GroupProperty* group = dynamic_cast<const GroupProperty*>(&prop);
+    if (group) {
+        kind = FlatTree::Kind::Group;
+        value = static_cast<double>(group->size());
+    } else if (const BooleanProperty* boolean = dynamic_cast<const BooleanProperty*>(&prop)) {
+        kind = FlatTree::Kind::Bool;
+        value = boolean->value() ? 1. : 0.;
+    } else if (const IntProperty* integer = dynamic_cast<const IntProperty*>(&prop)) {
+        kind = FlatTree::Kind::Int;
+        value = integer->value();
+        min = integer->min();
+        max = integer->max();
+    } else if (const DoubleProperty* real = dynamic_cast<const DoubleProperty*>(&prop)) {
+        kind = FlatTree::Kind::Double;
+        value = real->DoubleProperty::value();
+        min = real->min();
+        max = real->max();
+    } else if (const StringProperty* string = dynamic_cast<const StringProperty*>(&prop)) {
+        kind = FlatTree::Kind::String;
+        value = static_cast<double>(tree.strings.size());
+        tree.strings.push_back(string->value());
+    } else if (const WStringProperty* wide = dynamic_cast<const WStringProperty*>(&prop)) {
+        kind = FlatTree::Kind::WString;
+        value = static_cast<double>(tree.wideStrings.size());
+        tree.wideStrings.push_back(wide->value());
+    }
+
+    tree.paths.push_back(path);
+    tree.kinds.push_back(kind);
+    tree.parents.push_back(parent);
+    tree.values.push_back(value);
+    tree.minimums.push_back(min);
+    tree.maximums.push_back(max);
+    tree.fingerprints.push_back(prop.fingerprint());
+
+    if (group) {
+        for (const Property& child : *group)
+            flattenInto(child, path.empty() ? child.name() : path + "." + child.name(), row, tree);
+    }
+}
+
+size_t count(const Property& prop)
+{
+    size_t rows = 1;
+    if (const GroupProperty* group = dynamic_cast<const GroupProperty*>(&prop)) {
+        for (const Property& child : *group)
+            rows += count(child);
+    }
+    return rows;
+}
+}
+
+constexpr uint32_t FlatTree::noParent;
+
+size_t FlatTree::find(const std::string& path) const
+{
+    return static_cast<size_t>(std::find(paths.begin(), paths.end(), path) - paths.begin());
+}
+
+FlatTree flatten(const Property& root)
+{
+    FlatTree tree;
+    const size_t rows = count(root);
+    tree.paths.reserve(rows);
+    tree.kinds.reserve(rows);
+    tree.parents.reserve(rows);
+    tree.values.reserve(rows);
+    tree.minimums.reserve(rows);
+    tree.maximums.reserve(rows);
+    tree.fingerprints.reserve(rows);
+
+    flattenInto(root, "", FlatTree::noParent, tree);
+    return tree;
+}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "properties_export.h"
+#include "property.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace property
+{
+
+/// Property tree flattened into contiguous columns, one row per property in depth-first order with the root as row
+/// 0. Scans over the columns are plain linear loops, without virtual calls nor pointer chasing.
+struct PROPERTIES_EXPORT FlatTree {
+    enum class Kind : unsigned char { Group, Bool, Int, Double, String, WString, Other };
+
+    static constexpr uint32_t noParent = UINT32_MAX;
+
+    /// Dotted path from the root, empty for the root itself
+    std::vector<std::string> paths;
+    std::vector<Kind> kinds;
+    /// Row of the enclosing group, noParent for the root
+    std::vector<uint32_t> parents;
+    /// Bool, Int and Double: the value; Group: the number of children; String and WString: the row in strings or
+    /// wideStrings; Other: 0
+    std::vector<double> values;
+    /// Bounds of the numeric properties, -inf and +inf for the other kinds
+    std::vector<double> minimums;
+    std::vector<double> maximums;
+    std::vector<uint64_t> fingerprints;
+
+    std::vector<std::string> strings;
+    std::vector<std::wstring> wideStrings;
+
+    size_t size() const { return kinds.size(); }
+    /// Row of the property at path, or size() if there is none
+    size_t find(const std::string& path) const;
+};
+
+PROPERTIES_EXPORT FlatTree flatten(const Property& root);
+}
@@ -4,4 +4,68 @@ namespace property
 {
 
 const std::string GroupProperty::identifier = "group";
+
+uint64_t GroupProperty::fingerprint() const
+{
+    if (fingerprinted_.load(std::memory_order_acquire))
+        return fingerprint_.load(std::memory_order_relaxed);
+
+    Hasher hasher = header();
+    bool cacheable = true;
+    for (const Property& child : *this) {
+        adopt(child);
+        hasher.add(child.fingerprint());
+        // A child group which did not keep its fingerprint (an overlay, or a group enclosing one) is not told of all
+        // the changes below it, so this one cannot keep its own either
+        const GroupProperty* group = dynamic_cast<const GroupProperty*>(&child);
+        if (group && !group->fingerprinted_.load(std::memory_order_relaxed))
+            cacheable = false;
+    }
+    const uint64_t value = hasher.value();
+    if (cacheable) {
+        fingerprint_.store(value, std::memory_order_relaxed);
+        fingerprinted_.store(true, std::memory_order_release);
+    }
+    return value;
+}
+
+bool GroupProperty::equals(const Property& rhs) const
+{
+    const GroupProperty* other = dynamic_cast<const GroupProperty*>(&rhs);
+    if (!other || different(rhs) || size() != other->size() || fingerprint() != other->fingerprint())
+        return false;
+    for (auto it = begin(), jt = other->begin(); it != end(); ++it, ++jt) {
+        if (!it->equals(*jt))
+            return false;
+    }
+    return true;
+}
+
+void GroupProperty::memoise(uint64_t key, std::string serialised) const
+{
+    // Serialisers memoise the child groups first: one without a memo did not keep it, for the same reason as in
+    // fingerprint(), and this one must not either
+    for (const Property& child : *this) {
+        const GroupProperty* group = dynamic_cast<const GroupProperty*>(&child);
+        if (group && !group->memo_)
+            return;
+    }
+    for (const Property& child : *this)
+        adopt(child);
+    memoKey_ = key;
+    if (memo_)
+        *memo_ = std::move(serialised);
+    else
+        memo_ = std::make_unique<std::string>(std::move(serialised));
+}
+
+bool GroupProperty::invalidate() const
+{
+    // The enclosing groups can only have cached something if this one did
+    if (!fingerprinted_.load(std::memory_order_relaxed) && !memo_)
+        return false;
+    fingerprinted_.store(false, std::memory_order_relaxed);
+    memo_.reset();
+    return true;
+}
 }
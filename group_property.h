@@ -4,6 +4,7 @@
 #include "property.h"
 
 #include <array>
+#include <memory>
 
 namespace property
 {
@@ -23,9 +24,19 @@ public:
         : props_{props.data()}, pos_{begin ? 0 : N}, size_{N}
     {
     }
+    // Construction by groups which build their children on demand
+    struct Materialiser {
+        virtual ~Materialiser() = default;
+        /// Builds (once) and returns the child at the given position
+        virtual const Property* materialise(size_t pos) const = 0;
+    };
     // Copy-construction
     GroupPropertyIterator(const GroupPropertyIterator& rhs) = default;
-    GroupPropertyIterator(const Property* const* props, size_t pos, size_t size) : props_{props}, pos_{pos}, size_{size}
+    GroupPropertyIterator(const Property* const* props,
+                          size_t pos,
+                          size_t size,
+                          const Materialiser* materialiser = nullptr)
+        : props_{props}, pos_{pos}, size_{size}, materialiser_{materialiser}
     {
     }
     ~GroupPropertyIterator() = default;
@@ -37,22 +48,29 @@ public:
         ++pos_;
         return *this;
     }
-    GroupPropertyIterator operator++(int) { return GroupPropertyIterator(props_, pos_ + 1, size_); }
+    GroupPropertyIterator operator++(int) { return GroupPropertyIterator(props_, pos_ + 1, size_, materialiser_); }
     bool operator==(const GroupPropertyIterator& rhs) const { return !operator!=(rhs); }
     bool operator!=(const GroupPropertyIterator& rhs) const { return pos_ != rhs.pos_; }
-    reference operator*() const { return *props_[pos_]; }
-    pointer operator->() const { return props_[pos_]; }
+    reference operator*() const { return *operator->(); }
+    pointer operator->() const
+    {
+        const Property* prop = props_[pos_];
+        return prop || !materialiser_ ? prop : materialiser_->materialise(pos_);
+    }
 
 private:
     const Property* const* props_;
     size_t pos_;
     size_t size_;
+    const Materialiser* materialiser_{nullptr};
 };
 
 class PROPERTIES_EXPORT GroupProperty : public Property
 {
 public:
     GroupProperty(const std::string& name, const std::string& displayName = "") : Property(name, displayName) {}
+    /// The cached state belongs to the original
+    GroupProperty(const GroupProperty& rhs) : Property(rhs) {}
     ~GroupProperty() override {}
 
     STR(out << "="; stream::convert(out, identifier) << "["; auto it = begin(); if (it != end()) it->str(out);
@@ -64,6 +82,9 @@ public:
 
     static const std::string identifier;
     const std::string& id() const override { return identifier; }
+    uint64_t fingerprint() const override;
+    /// Children are compared in order
+    bool equals(const Property& rhs) const override;
 
     virtual GroupPropertyIterator begin() const = 0;
     virtual GroupPropertyIterator find(const std::string& name) const
@@ -76,6 +97,18 @@ public:
     }
     virtual GroupPropertyIterator end() const = 0;
     virtual size_t size() const = 0;
+    /// True if the children always have the same names in the same order
+    virtual bool fixedLayout() const { return false; }
+    /// False for groups presenting children which they do not own and which other groups may share (e.g. overlays):
+    /// writing through them would change those groups too, so Accessor and assign refuse it
+    virtual bool writable() const { return true; }
+
+    /// Serialised form kept by a serialiser under a key of its own (format and options), or null if there is none.
+    /// It is dropped, with the fingerprint, when a descendant changes.
+    const std::string* memo(uint64_t key) const { return memo_ && memoKey_ == key ? memo_.get() : nullptr; }
+    /// Keeps the serialised form of the group, replacing the one kept under another key. The children are adopted,
+    /// so that their changes drop it. Nothing is kept if a child group kept nothing, as overlays do.
+    virtual void memoise(uint64_t key, std::string serialised) const;
 
     template <class T>
     const T& get(const std::string& name) const
@@ -85,5 +118,24 @@ public:
             return it->cast<T>();
         throw std::out_of_range("No child with name: " + name);
     }
+
+protected:
+    bool invalidate() const override;
+    /// Records this group as the parent of the child, whose changes will then invalidate its cached state
+    void adopt(const Property& child) const { child.parent_.store(this, std::memory_order_relaxed); }
+    /// Forgets a child leaving the group, whose changes must no longer reach it
+    void disown(const Property& child) const
+    {
+        const Property* self = this;
+        child.parent_.compare_exchange_strong(self, nullptr, std::memory_order_relaxed);
+    }
+
+private:
+    /// Threads reading the tree at once may all compute the fingerprint, which is the same, and publish it through
+    /// fingerprinted_. The memo is kept by serialisers, which document that they must not memoise concurrently.
+    mutable std::atomic<uint64_t> fingerprint_{0};
+    mutable std::atomic<bool> fingerprinted_{false};
+    mutable uint64_t memoKey_{0};
+    mutable std::unique_ptr<std::string> memo_;
 };
 }
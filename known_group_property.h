@@ -19,6 +19,7 @@ public:
     GroupPropertyIterator begin() const override { return GroupPropertyIterator(children_, true); }
     GroupPropertyIterator end() const override { return GroupPropertyIterator(children_, false); }
     size_t size() const override { return N; }
+    bool fixedLayout() const override { return true; }
 
 private:
     const Children children_;
@@ -8,11 +8,47 @@
 namespace property
 {
 
+/// Name, display name and bounds of numeric properties. The bounds are shared with the name, so an IntProperty or a
+/// DoubleProperty takes 48 bytes on 64-bit platforms whatever its bounds.
+template <class T>
+class NumericDescriptor : public Descriptor
+{
+public:
+    using value_type = T;
+
+    NumericDescriptor(const std::string& name,
+                      const value_type& min,
+                      const value_type& max,
+                      const std::string& displayName = "")
+        : Descriptor(name, displayName), min_{min}, max_{max}
+    {
+        if (min_ > max_) {
+            throw std::out_of_range("Min " + std::to_string(min_) + " must be smaller or equal to max " +
+                                    std::to_string(max_));
+        }
+    }
+
+    const value_type& min() const { return min_; }
+    const value_type& max() const { return max_; }
+
+    uint64_t hash() const override { return Hasher().add(Descriptor::hash()).add(min_).add(max_).value(); }
+    bool equals(const Descriptor& rhs) const override
+    {
+        return Descriptor::equals(rhs) && min_ == static_cast<const NumericDescriptor&>(rhs).min_ &&
+               max_ == static_cast<const NumericDescriptor&>(rhs).max_;
+    }
+
+private:
+    const value_type min_;
+    const value_type max_;
+};
+
 template <class T>
 class PROPERTIES_EXPORT NumericProperty : public Property
 {
 public:
     using value_type = T;
+    using Descriptor = NumericDescriptor<T>;
     static constexpr value_type has_inf = std::numeric_limits<value_type>::has_infinity;
     static constexpr value_type max_value =
         has_inf ? std::numeric_limits<value_type>::infinity() : std::numeric_limits<value_type>::max();
@@ -22,32 +58,34 @@ public:
                     const value_type& min = value_type(-max_value),
                     const value_type& max = value_type(max_value),
                     const std::string& displayName = "")
-        : Property(name, displayName), value_{value}, min_{min}, max_{max}
+        : NumericProperty(std::make_shared<const Descriptor>(name, min, max, displayName), value)
     {
-        if (min_ > max_) {
-            throw std::out_of_range("Min " + std::to_string(min_) + " must be smaller or equal to max " +
-                                    std::to_string(max_));
-        }
-        if (value_ < min_) {
-            throw std::out_of_range("Min value " + std::to_string(min_) + " was not respected: " +
-                                    std::to_string(value_));
-        }
-        if (value_ > max_) {
-            throw std::out_of_range("Max value " + std::to_string(max_) + " was not respected: " +
-                                    std::to_string(value_));
-        }
     }
     NumericProperty(const std::string& name, const value_type& value, const std::string displayName)
         : NumericProperty(name, value, value_type(-max_value), value_type(max_value), displayName)
     {
     }
+    /// Shares the descriptor of rhs when the name and display name are the same
     NumericProperty(const std::string& name, const NumericProperty& rhs, const std::string displayName = "")
-        : NumericProperty(name,
-                          rhs.value(),
-                          rhs.min(),
-                          rhs.max(),
-                          displayName.empty() ? rhs.displayName() : displayName)
+        : NumericProperty(name == rhs.name() && (displayName.empty() || displayName == rhs.displayName())
+                              ? rhs.descriptor()
+                              : std::make_shared<const Descriptor>(
+                                    name, rhs.min(), rhs.max(), displayName.empty() ? rhs.displayName() : displayName),
+                          rhs.value())
+    {
+    }
+    /// Property described by a descriptor shared with others, e.g. the instances of one field of a schema
+    NumericProperty(std::shared_ptr<const Descriptor> descriptor, const value_type& value)
+        : Property(std::move(descriptor)), value_{value}
     {
+        if (value_ < min()) {
+            throw std::out_of_range("Min value " + std::to_string(min()) + " was not respected: " +
+                                    std::to_string(value_));
+        }
+        if (value_ > max()) {
+            throw std::out_of_range("Max value " + std::to_string(max()) + " was not respected: " +
+                                    std::to_string(value_));
+        }
     }
 
     ~NumericProperty() override {}
@@ -56,25 +94,27 @@ public:
     NumericProperty& operator=(const NumericProperty& rhs)
     {
         value_ = rhs.value_;
-        min_ = rhs.min_;
-        max_ = rhs.max_;
+        if (min() != rhs.min() || max() != rhs.max())
+            setDescriptor(std::make_shared<const Descriptor>(name(), rhs.min(), rhs.max(), displayName()));
+        changed();
         return *this;
     }
     NumericProperty& operator=(const value_type& value)
     {
-        if (value < min_) {
+        if (value < min()) {
             throw std::out_of_range("Min value was not respected");
         }
-        if (value > max_) {
+        if (value > max()) {
             throw std::out_of_range("Max value was not respected");
         }
         value_ = value;
+        changed();
         return *this;
     }
     bool operator==(const NumericProperty& rhs) const { return !operator!=(rhs); }
     bool operator!=(const NumericProperty& rhs) const
     {
-        return different(rhs) || value_ != rhs.value_ || min_ != rhs.min_ || max_ != rhs.max_;
+        return different(rhs) || value_ != rhs.value_ || min() != rhs.min() || max() != rhs.max();
     }
 
     STR(out << "="; stream::convert(out, identifier) << "["; stream::convert(out, value_) << "]";)
@@ -82,10 +122,21 @@ public:
 public:
     static const std::string identifier;
     const std::string& id() const override { return identifier; }
+    uint64_t fingerprint() const override { return header().add(value_).add(min()).add(max()).value(); }
+    bool equals(const Property& rhs) const override
+    {
+        const NumericProperty* other = dynamic_cast<const NumericProperty*>(&rhs);
+        return other && *this == *other;
+    }
 
     const value_type& value() const { return value_; }
-    const value_type& min() const { return min_; }
-    const value_type& max() const { return max_; }
+    /// Name, display name and bounds, shared with the properties built from the same descriptor
+    std::shared_ptr<const Descriptor> descriptor() const
+    {
+        return std::static_pointer_cast<const Descriptor>(Property::descriptor());
+    }
+    const value_type& min() const { return static_cast<const Descriptor&>(*Property::descriptor()).min(); }
+    const value_type& max() const { return static_cast<const Descriptor&>(*Property::descriptor()).max(); }
 
     static NumericProperty convert(const Property& property)
     {
@@ -95,8 +146,6 @@ public:
 
 private:
     value_type value_;
-    value_type min_;
-    value_type max_;
 };
 
 using IntProperty = NumericProperty<int>;
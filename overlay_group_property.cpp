@@ -0,0 +1,105 @@
+#include "overlay_group_property.h"
+
+namespace property
+{
+
+namespace
+{
+
+const GroupProperty& top(const std::vector<const GroupProperty*>& layers)
+{
+    if (layers.empty())
+        throw std::invalid_argument("An overlay needs at least one layer");
+    return *layers.back();
+}
+}
+
+OverlayGroupProperty::OverlayGroupProperty(std::vector<const GroupProperty*> layers)
+    : OverlayGroupProperty(top(layers).name(), layers, top(layers).displayName())
+{
+}
+
+OverlayGroupProperty::OverlayGroupProperty(const std::string& name,
+                                           std::vector<const GroupProperty*> layers,
+                                           const std::string& displayName)
+    : GroupProperty(name, displayName), layers_{std::move(layers)}
+{
+}
+
+OverlayGroupProperty::~OverlayGroupProperty() = default;
+
+GroupPropertyIterator OverlayGroupProperty::begin() const
+{
+    resolve();
+    return GroupPropertyIterator{children_.data(), 0, children_.size()};
+}
+
+GroupPropertyIterator OverlayGroupProperty::find(const std::string& name) const
+{
+    resolve();
+    auto it = index_.find(name);
+    return it != index_.end() ? GroupPropertyIterator{children_.data(), it->second, children_.size()} : end();
+}
+
+GroupPropertyIterator OverlayGroupProperty::end() const
+{
+    resolve();
+    return GroupPropertyIterator{children_.data(), children_.size(), children_.size()};
+}
+
+size_t OverlayGroupProperty::size() const
+{
+    resolve();
+    return children_.size();
+}
+
+uint64_t OverlayGroupProperty::fingerprint() const
+{
+    Hasher hasher = header();
+    for (const Property& child : *this)
+        hasher.add(child.fingerprint());
+    return hasher.value();
+}
+
+void OverlayGroupProperty::refresh()
+{
+    resolved_ = false;
+    children_.clear();
+    index_.clear();
+    nested_.clear();
+}
+
+void OverlayGroupProperty::resolve() const
+{
+    if (resolved_)
+        return;
+
+    // Groups which a child overlays, up to the last layer where it is not a group
+    std::vector<std::vector<const GroupProperty*>> groups;
+    for (const GroupProperty* layer : layers_) {
+        for (const Property& child : *layer) {
+            auto inserted = index_.emplace(child.name(), children_.size());
+            const size_t position = inserted.first->second;
+            if (inserted.second) {
+                children_.push_back(&child);
+                groups.emplace_back();
+            } else {
+                children_[position] = &child;
+            }
+            const GroupProperty* group = dynamic_cast<const GroupProperty*>(&child);
+            if (group)
+                groups[position].push_back(group);
+            else
+                groups[position].clear();
+        }
+    }
+    for (size_t position = 0; position < children_.size(); ++position) {
+        if (groups[position].size() > 1) {
+            nested_.emplace_back(new OverlayGroupProperty(
+                children_[position]->name(), std::move(groups[position]), children_[position]->displayName()));
+            children_[position] = nested_.back().get();
+        }
+    }
+    resolved_ = true;
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "group_property.h"
+#include "properties_export.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace property
+{
+
+/// Several groups presented as one, e.g. defaults, site and per-host settings, without copying any property. Each
+/// child is taken from the last layer that has one with its name, in the order of its first appearance; children
+/// which are groups in several layers are overlaid in turn.
+///
+/// The resolution is made on first access and cached: after inserting children in or removing children from a layer,
+/// refresh() must be called, which also destroys the nested overlays handed out so far. Changes of values need no
+/// refresh, the children being the properties of the layers themselves. Layers are typically shared by several
+/// overlays, so the overlay is not writable(): values are written into a layer directly. As for lazy groups, the
+/// overlay must not be read concurrently from several threads before its first resolution.
+class PROPERTIES_EXPORT OverlayGroupProperty : public GroupProperty
+{
+public:
+    /// Layers from the lowest priority to the highest, which must outlive the overlay. The name and display name
+    /// are those of the last layer.
+    explicit OverlayGroupProperty(std::vector<const GroupProperty*> layers);
+    OverlayGroupProperty(const std::string& name,
+                         std::vector<const GroupProperty*> layers,
+                         const std::string& displayName = "");
+    OverlayGroupProperty(const OverlayGroupProperty&) = delete;
+    OverlayGroupProperty& operator=(const OverlayGroupProperty&) = delete;
+    ~OverlayGroupProperty() override;
+
+    GroupPropertyIterator begin() const override;
+    GroupPropertyIterator find(const std::string& name) const override;
+    GroupPropertyIterator end() const override;
+    size_t size() const override;
+    /// Computed from the fingerprints cached by the layers each time: the overlay does not adopt their children, so
+    /// it is not told of their changes, and the groups enclosing it do not keep their fingerprints or memos either
+    uint64_t fingerprint() const override;
+    /// Not kept either, for the same reason
+    void memoise(uint64_t /*key*/, std::string /*serialised*/) const override {}
+    bool writable() const override { return false; }
+
+    const std::vector<const GroupProperty*>& layers() const { return layers_; }
+    /// Resolves the children again on next access
+    void refresh();
+
+private:
+    void resolve() const;
+
+private:
+    const std::vector<const GroupProperty*> layers_;
+    mutable bool resolved_{false};
+    mutable std::vector<const Property*> children_;
+    mutable std::unordered_map<std::string, size_t> index_;
+    mutable std::vector<std::unique_ptr<OverlayGroupProperty>> nested_;
+};
+}
@@ -0,0 +1,219 @@
+#include "change_log.h"
+
+#include "../accessor.h"
+#include "file_store.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace property
+{
+
+namespace
+{
+
+void writeVarint(std::string& out, size_t value)
+{
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+/// False if the data ends before the varint
+bool readVarint(const char*& pos, const char* end, size_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; pos != end && shift < 64; shift += 7) {
+        const unsigned char c = *pos++;
+        value |= static_cast<size_t>(c & 0x7F) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool exists(const std::string& path)
+{
+    return ::access(path.c_str(), F_OK) == 0;
+}
+
+/// Moves the records of the log at from to the end of the log at to, which the replay reads first
+void append(const std::string& from, const std::string& to)
+{
+    {
+        MappedFile source(from);
+        const int fd = ::open(to.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot open " + to);
+        const char* data = source.data();
+        const char* end = data + source.size();
+        while (data != end) {
+            const ssize_t written = ::write(fd, data, end - data);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "Cannot append to " + to);
+            }
+            data += written;
+        }
+        const bool synced = ::fsync(fd) == 0;
+        const int error = errno;
+        ::close(fd);
+        if (!synced)
+            throw std::system_error(error, std::generic_category(), "Cannot sync " + to);
+    }
+    // Until then, the records are in both logs and would be replayed twice, which is harmless
+    if (::unlink(from.c_str()) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot remove " + from);
+}
+}
+
+ChangeLog::ChangeLog(const std::string& path, const JSONSerialiser& serialiser)
+    : path_{path}, log_{path + ".log"}, compacting_{path + ".log.compacting"}, serialiser_{serialiser}
+{
+    open();
+}
+
+ChangeLog::~ChangeLog()
+{
+    if (compaction_.joinable())
+        compaction_.join();
+    ::close(fd_);
+}
+
+std::unique_ptr<Property> ChangeLog::load() const
+{
+    std::unique_ptr<Property> root;
+    {
+        MappedFile snapshot(path_);
+        root = serialiser_.deserialise(snapshot.data(), snapshot.size());
+    }
+    GroupProperty& group = root->cast<GroupProperty>();
+    // Records of an interrupted compaction precede the current ones, and may already be in the snapshot: replaying
+    // assignments twice is harmless
+    if (exists(compacting_))
+        replay(compacting_, group);
+    if (exists(log_))
+        replay(log_, group);
+    return root;
+}
+
+void ChangeLog::record(const std::string& path, const Property& value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Framed as: varint size of the rest, varint size of the path, path, binary property
+    body_.clear();
+    writeVarint(body_, path.size());
+    body_ += path;
+    BinarySerialiser::shared().serialise(value, body_);
+    record_.clear();
+    writeVarint(record_, body_.size());
+    record_ += body_;
+
+    const char* data = record_.data();
+    const char* end = data + record_.size();
+    while (data != end) {
+        const ssize_t written = ::write(fd_, data, end - data);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0)
+            throw std::system_error(errno, std::generic_category(), "Cannot append to " + log_);
+        data += written;
+    }
+    size_ += record_.size();
+}
+
+void ChangeLog::sync()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (::fsync(fd_) != 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot sync " + log_);
+}
+
+size_t ChangeLog::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+void ChangeLog::compact(const Property& tree)
+{
+    wait();
+    {
+        // The log is set aside before the tree is serialised: records made meanwhile go to the new log, and are
+        // replayed once more if the snapshot includes them
+        std::lock_guard<std::mutex> lock(mutex_);
+        ::close(fd_);
+        fd_ = -1;
+        try {
+            // The records of a compaction which failed are still needed until this one succeeds
+            if (exists(compacting_))
+                append(log_, compacting_);
+            else if (::rename(log_.c_str(), compacting_.c_str()) != 0)
+                throw std::system_error(errno, std::generic_category(), "Cannot rename " + log_);
+        } catch (...) {
+            open();
+            throw;
+        }
+        open();
+    }
+    std::string content;
+    serialiser_.serialise(tree, content);
+    compaction_ = std::thread([this](std::string content) {
+        try {
+            writeAtomically(path_, content);
+            ::unlink(compacting_.c_str());
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }, std::move(content));
+}
+
+void ChangeLog::wait()
+{
+    if (compaction_.joinable())
+        compaction_.join();
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ChangeLog::open()
+{
+    fd_ = ::open(log_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + log_);
+    struct stat status;
+    size_ = ::fstat(fd_, &status) == 0 ? status.st_size : 0;
+}
+
+void ChangeLog::replay(const std::string& path, GroupProperty& root)
+{
+    MappedFile log(path);
+    const char* pos = log.data();
+    const char* end = pos + log.size();
+    size_t size;
+    while (pos != end && readVarint(pos, end, size) && size <= static_cast<size_t>(end - pos)) {
+        const char* record = pos;
+        const char* recordEnd = pos + size;
+        pos = recordEnd;
+        size_t pathSize;
+        if (!readVarint(record, recordEnd, pathSize) || pathSize > static_cast<size_t>(recordEnd - record))
+            throw std::runtime_error("Malformed record in " + path);
+        const std::string propertyPath(record, pathSize);
+        record += pathSize;
+        auto value = BinarySerialiser::shared().deserialise(record, recordEnd - record);
+        assign(root, propertyPath, *value);
+    }
+}
+}
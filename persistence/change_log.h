@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../serialisation/binary_serialiser.h"
+#include "../serialisation/json_serialiser.h"
+#include "properties_export.h"
+
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace property
+{
+
+/// Append-only log of assignments kept next to a JSON snapshot of the tree. Recording an assignment appends its path
+/// and binary-encoded property to <path>.log, so persisting a change costs O(change). Compaction rewrites the
+/// snapshot in the background and drops the records it includes.
+class PROPERTIES_EXPORT ChangeLog
+{
+public:
+    ChangeLog(const std::string& path, const JSONSerialiser& serialiser = JSONSerialiser::shared());
+    ChangeLog(const ChangeLog&) = delete;
+    ChangeLog& operator=(const ChangeLog&) = delete;
+    /// Waits for the running compaction, if any
+    ~ChangeLog();
+
+    /// Loads the snapshot and replays the recorded assignments on it. A record truncated by a crash ends the replay.
+    std::unique_ptr<Property> load() const;
+
+    /// Appends the assignment of value to the property at the dotted path
+    void record(const std::string& path, const Property& value);
+    /// Forces the records written so far to disk
+    void sync();
+    /// Size in bytes of the records since the last compaction
+    size_t size() const;
+
+    /// Writes the tree as the new snapshot in the background; the tree must include every recorded assignment. Waits
+    /// for the previous compaction first. The records of compactions which failed are kept until one succeeds.
+    void compact(const Property& tree);
+    /// Waits for the running compaction, rethrows its error if any
+    void wait();
+
+private:
+    void open();
+    static void replay(const std::string& path, GroupProperty& root);
+
+private:
+    const std::string path_;
+    const std::string log_;
+    /// Log being dropped by the running compaction
+    const std::string compacting_;
+    const JSONSerialiser& serialiser_;
+
+    mutable std::mutex mutex_;
+    int fd_{-1};
+    size_t size_{0};
+    /// Buffers reused by the records
+    std::string body_;
+    std::string record_;
+
+    std::thread compaction_;
+    std::exception_ptr error_;
+};
+}
@@ -0,0 +1,138 @@
+#include "config_watcher.h"
+
+#include "file_store.h"
+
+#include "../accessor.h"
+#include "../diff.h"
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace property
+{
+
+namespace
+{
+
+[[noreturn]] void fail(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+/// The property at a path of a diff, the root itself for the empty path
+const Property& at(const GroupProperty& root, const std::string& path)
+{
+    return path.empty() ? root : resolve(root, path);
+}
+
+// Written in place, or replaced by another file of the directory
+const uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO;
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& path,
+                             GroupProperty& tree,
+                             Restructured restructured,
+                             const JSONSerialiser& serialiser)
+    : path_{path}, tree_{tree}, restructured_{std::move(restructured)}, serialiser_{serialiser}
+{
+    const size_t slash = path.rfind('/');
+    directory_ = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    name_ = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0)
+        fail("Cannot watch " + path);
+    if (::inotify_add_watch(fd_, directory_.c_str(), events) < 0) {
+        const int error = errno;
+        ::close(fd_);
+        errno = error;
+        fail("Cannot watch " + directory_);
+    }
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    ::close(fd_);
+}
+
+size_t ConfigWatcher::poll(std::chrono::milliseconds timeout)
+{
+    pollfd descriptor{fd_, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&descriptor, 1, static_cast<int>(timeout.count()));
+    } while (ready < 0 && errno == EINTR);
+    if (ready < 0)
+        fail("Cannot poll " + path_);
+    if (ready == 0)
+        return 0;
+
+    // Drain every pending event, so that a burst of writes is reloaded once
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+    while (true) {
+        const ssize_t size = ::read(fd_, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size < 0 && errno == EAGAIN)
+            break;
+        if (size <= 0)
+            fail("Cannot read the events of " + path_);
+        for (const char* event = buffer; event < buffer + size;) {
+            const inotify_event& header = *reinterpret_cast<const inotify_event*>(event);
+            if (header.len && name_ == header.name)
+                changed = true;
+            // Events were dropped, the file may have changed
+            if (header.mask & IN_Q_OVERFLOW)
+                changed = true;
+            // The watch was removed with the directory (or its file system), which must be watched again
+            if (header.mask & IN_IGNORED) {
+                if (::inotify_add_watch(fd_, directory_.c_str(), events) < 0)
+                    fail("Cannot watch " + directory_);
+                changed = true;
+            }
+            event += sizeof(inotify_event) + header.len;
+        }
+    }
+    return changed ? reload() : 0;
+}
+
+size_t ConfigWatcher::reload()
+{
+    std::unique_ptr<Property> loaded;
+    {
+        MappedFile file(path_);
+        loaded = serialiser_.deserialise(file.data(), file.size());
+    }
+
+    // Every change is checked before the first is applied, so that the tree is either updated or left as is
+    const std::vector<Change> changes = diff(tree_, *loaded);
+    const GroupProperty* loadedGroup = dynamic_cast<const GroupProperty*>(loaded.get());
+    std::vector<std::pair<Property*, const Property*>> assignments;
+    bool inPlace = loadedGroup != nullptr;
+    for (auto change = changes.begin(); inPlace && change != changes.end(); ++change) {
+        inPlace = change->kind == Change::Kind::Modified && !change->path.empty();
+        if (!inPlace)
+            break;
+        // Throws std::invalid_argument below groups which cannot be written, e.g. overlays
+        Property& target = resolveWritable(tree_, change->path);
+        const Property& source = at(*loadedGroup, change->path);
+        // Groups are reported as modified when replaced by a leaf, or when their names differ
+        inPlace = assignable(target, source);
+        assignments.emplace_back(&target, &source);
+    }
+    if (!inPlace) {
+        if (restructured_)
+            restructured_(std::move(loaded));
+        return 0;
+    }
+
+    for (const auto& assignment : assignments)
+        assign(*assignment.first, *assignment.second);
+    return assignments.size();
+}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../group_property.h"
+#include "../serialisation/json_serialiser.h"
+#include "properties_export.h"
+
+#include <chrono>
+#include <functional>
+
+namespace property
+{
+
+/// Keeps a live tree in step with the config file it was loaded from. The file is watched with inotify; on a change
+/// it is loaded again, diffed against the live tree, and only the properties which changed are assigned, in place:
+/// references, accessors and the cached state of the unchanged groups stay valid, and change feeds see the changed
+/// properties only.
+///
+/// Edits which change the shape of the tree (a property added or removed, or of another type) cannot be applied in
+/// place: the loaded tree is then handed to the restructured callback, to be swapped in by the owner of the live
+/// tree, which is left as is. Display names are not compared, as for diff().
+///
+/// Changes are only applied by poll() and reload(), on the thread calling them, which must be the one modifying the
+/// tree. The watch survives the file being replaced, e.g. by writeAtomically or by editors renaming a new copy. The
+/// file is also reloaded when inotify dropped events, or when the watch of the directory had to be set up again.
+class PROPERTIES_EXPORT ConfigWatcher
+{
+public:
+    using Restructured = std::function<void(std::unique_ptr<Property> loaded)>;
+
+    /// Starts watching the file; the tree is assumed to match its current content. Throws std::system_error if the
+    /// watch cannot be set up.
+    ConfigWatcher(const std::string& path,
+                  GroupProperty& tree,
+                  Restructured restructured = nullptr,
+                  const JSONSerialiser& serialiser = JSONSerialiser::shared());
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+    ~ConfigWatcher();
+
+    /// Waits up to timeout for the file to change, and reloads it if it did. Returns the number of properties
+    /// assigned. Errors of the reload are thrown, the live tree being left unchanged; a change below a group which
+    /// is not writable() throws std::invalid_argument.
+    size_t poll(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    /// Loads the file and applies its changes now
+    size_t reload();
+
+    /// Descriptor which becomes readable when the file changes, for event loops calling poll() when it is
+    int fd() const { return fd_; }
+    const std::string& path() const { return path_; }
+
+private:
+    const std::string path_;
+    /// Directory of the file, and name of the file in it: the directory is watched so that replacing the file is
+    /// noticed
+    std::string directory_;
+    std::string name_;
+    GroupProperty& tree_;
+    const Restructured restructured_;
+    const JSONSerialiser& serialiser_;
+    int fd_{-1};
+};
+}
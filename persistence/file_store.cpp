@@ -0,0 +1,174 @@
+#include "file_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace property
+{
+
+namespace
+{
+
+[[noreturn]] void fail(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+/// Closes the file descriptor when leaving the scope
+struct FileDescriptor {
+    explicit FileDescriptor(int fd) : fd_{fd} {}
+    ~FileDescriptor()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+    int fd_;
+};
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    FileDescriptor file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.fd_ < 0)
+        fail("Cannot open " + path);
+    struct stat status;
+    if (::fstat(file.fd_, &status) != 0)
+        fail("Cannot stat " + path);
+    size_ = status.st_size;
+    // Empty files cannot be mapped
+    if (size_ == 0)
+        return;
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file.fd_, 0);
+    if (data == MAP_FAILED)
+        fail("Cannot map " + path);
+    ::madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_)
+        ::munmap(const_cast<char*>(data_), size_);
+}
+
+void writeAtomically(const std::string& path, const std::string& content)
+{
+    // Named uniquely in the same directory, so that concurrent writers do not share it and the rename stays atomic
+    std::string temporary = path + ".XXXXXX";
+    {
+        FileDescriptor file(::mkostemp(&temporary[0], O_CLOEXEC));
+        if (file.fd_ < 0)
+            fail("Cannot create " + temporary);
+        try {
+            // mkostemp creates the file readable by its owner only
+            if (::fchmod(file.fd_, 0644) != 0)
+                fail("Cannot change the mode of " + temporary);
+            const char* data = content.data();
+            const char* end = data + content.size();
+            while (data != end) {
+                const ssize_t written = ::write(file.fd_, data, end - data);
+                if (written < 0 && errno == EINTR)
+                    continue;
+                if (written < 0)
+                    fail("Cannot write " + temporary);
+                data += written;
+            }
+            if (::fsync(file.fd_) != 0)
+                fail("Cannot sync " + temporary);
+            if (::rename(temporary.c_str(), path.c_str()) != 0)
+                fail("Cannot rename " + temporary);
+        } catch (...) {
+            ::unlink(temporary.c_str());
+            throw;
+        }
+    }
+
+    // Make the rename itself durable
+    const size_t slash = path.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    FileDescriptor parent(::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (parent.fd_ >= 0)
+        ::fsync(parent.fd_);
+}
+
+FileStore::FileStore(const std::string& path, const JSONSerialiser& serialiser, JSONSerialiser::Profile profile)
+    : path_{path}, serialiser_{serialiser}, profile_{profile}, writer_{&FileStore::write, this}
+{
+}
+
+FileStore::~FileStore()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    writer_.join();
+}
+
+void FileStore::save(const Property& prop)
+{
+    std::string content;
+    serialiser_.serialise(prop, content, profile_);
+    save(std::move(content));
+}
+
+void FileStore::save(std::string content)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Replaces the previous save if it was not picked up yet
+        pending_.swap(content);
+        ++requested_;
+    }
+    changed_.notify_all();
+}
+
+void FileStore::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this]() { return written_ == requested_; });
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+std::unique_ptr<Property> FileStore::load(JSONSerialiser::Materialisation materialisation) const
+{
+    MappedFile file(path_);
+    return serialiser_.deserialise(file.data(), file.size(), materialisation);
+}
+
+void FileStore::write()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::string content;
+    while (true) {
+        changed_.wait(lock, [this]() { return stopping_ || written_ != requested_; });
+        if (written_ == requested_)
+            return;
+
+        const size_t requested = requested_;
+        content.swap(pending_);
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            writeAtomically(path_, content);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        written_ = requested;
+        if (error)
+            error_ = error;
+        changed_.notify_all();
+    }
+}
+}
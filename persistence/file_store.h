@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../serialisation/json_serialiser.h"
+#include "properties_export.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace property
+{
+
+/// Read-only memory mapping of a whole file
+class PROPERTIES_EXPORT MappedFile
+{
+public:
+    /// Throws std::system_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_{nullptr};
+    size_t size_{0};
+};
+
+/// Writes the whole content to a temporary file, syncs it and renames it over path, so that readers only ever see
+/// the previous or the new content. Throws std::system_error on failure.
+PROPERTIES_EXPORT void writeAtomically(const std::string& path, const std::string& content);
+
+/// Persists a property tree in a local file. Saves are written by a background thread, so that the threads which
+/// request them never wait for the disk; saves requested while another is being written are coalesced, only the
+/// latest being written.
+class PROPERTIES_EXPORT FileStore
+{
+public:
+    FileStore(const std::string& path,
+              const JSONSerialiser& serialiser = JSONSerialiser::shared(),
+              JSONSerialiser::Profile profile = JSONSerialiser::Profile::Verbose);
+    FileStore(const FileStore&) = delete;
+    FileStore& operator=(const FileStore&) = delete;
+    /// Writes the pending save, if any
+    ~FileStore();
+
+    /// Serialises the tree on the calling thread and queues its content
+    void save(const Property& prop);
+    /// Queues already serialised content
+    void save(std::string content);
+    /// Blocks until everything saved so far is written, rethrows the error of the last failed write if any
+    void flush();
+
+    /// Loads the file through a memory mapping
+    std::unique_ptr<Property> load(
+        JSONSerialiser::Materialisation materialisation = JSONSerialiser::Materialisation::Eager) const;
+
+    const std::string& path() const { return path_; }
+
+private:
+    void write();
+
+private:
+    const std::string path_;
+    const JSONSerialiser& serialiser_;
+    const JSONSerialiser::Profile profile_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::string pending_;
+    /// Number of saves requested and written
+    size_t requested_{0};
+    size_t written_{0};
+    std::exception_ptr error_;
+    bool stopping_{false};
+    std::thread writer_;
+};
+}
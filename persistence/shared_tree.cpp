@@ -0,0 +1,572 @@
+#include "shared_tree.h"
+
+#include "../basic_property.h"
+#include "../group_property.h"
+#include "../numeric_property.h"
+#include "../serialisation/owned_group_property.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <thread>
+
+namespace property
+{
+
+namespace
+{
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared values need lock-free 64-bit atomics");
+
+constexpr uint32_t magic = 0x53505250; // "PRPS"
+constexpr uint32_t layoutVersion = 1;
+/// Attempts of a reader to find the values between two publications
+constexpr unsigned maxAttempts = 1000;
+
+enum class Kind : uint8_t { Group, Bool, Int, Double, String };
+
+/// Start of the segment, followed by the entries, the names, and the values
+struct Header {
+    /// Written last, once the segment is complete
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    /// Odd while the publisher writes the values, increased by 2 by every publication
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint32_t> retired;
+    /// Number of entries, i.e. of properties in depth-first order
+    uint32_t entries;
+    /// Offsets of the names and of the values from the start of the segment
+    uint32_t names;
+    uint32_t values;
+    uint32_t words;
+    uint32_t padding;
+};
+
+struct Entry {
+    Kind kind;
+    uint8_t padding[3];
+    /// Number of children of a group
+    uint32_t children;
+    /// Ranges of the names area
+    uint32_t name;
+    uint32_t nameSize;
+    uint32_t display;
+    uint32_t displaySize;
+    /// First value word of a leaf; strings store their length then their bytes
+    uint32_t slot;
+    /// Bytes of a string
+    uint32_t capacity;
+    /// Bounds of numeric properties, as stored in value words
+    uint64_t min;
+    uint64_t max;
+};
+
+[[noreturn]] void fail(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+size_t padded(size_t size)
+{
+    return (size + 7) & ~size_t(7);
+}
+
+uint64_t word(bool value)
+{
+    return value ? 1 : 0;
+}
+
+uint64_t word(int value)
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(value));
+}
+
+uint64_t word(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double real(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+Kind kindOf(const Property& prop)
+{
+    if (dynamic_cast<const GroupProperty*>(&prop))
+        return Kind::Group;
+    if (dynamic_cast<const BooleanProperty*>(&prop))
+        return Kind::Bool;
+    if (dynamic_cast<const IntProperty*>(&prop))
+        return Kind::Int;
+    if (dynamic_cast<const DoubleProperty*>(&prop))
+        return Kind::Double;
+    if (dynamic_cast<const StringProperty*>(&prop))
+        return Kind::String;
+    throw std::invalid_argument("Cannot share a property of type " + prop.id());
+}
+
+/// Lays out the shape of a tree, in depth-first order
+struct Layout {
+    void add(const Property& prop, size_t stringCapacity)
+    {
+        Entry entry{};
+        entry.kind = kindOf(prop);
+        entry.name = static_cast<uint32_t>(names.size());
+        entry.nameSize = static_cast<uint32_t>(prop.name().size());
+        names += prop.name();
+        entry.display = static_cast<uint32_t>(names.size());
+        entry.displaySize = static_cast<uint32_t>(prop.displayName().size());
+        names += prop.displayName();
+        entry.slot = words;
+
+        switch (entry.kind) {
+        case Kind::Group: {
+            const GroupProperty& group = prop.cast<GroupProperty>();
+            entry.children = static_cast<uint32_t>(group.size());
+            entries.push_back(entry);
+            for (const Property& child : group)
+                add(child, stringCapacity);
+            return;
+        }
+        case Kind::Int:
+            entry.min = word(prop.cast<IntProperty>().min());
+            entry.max = word(prop.cast<IntProperty>().max());
+            words += 1;
+            break;
+        case Kind::Double:
+            entry.min = word(prop.cast<DoubleProperty>().min());
+            entry.max = word(prop.cast<DoubleProperty>().max());
+            words += 1;
+            break;
+        case Kind::Bool:
+            words += 1;
+            break;
+        case Kind::String:
+            entry.capacity =
+                static_cast<uint32_t>(padded(std::max(stringCapacity, prop.cast<StringProperty>().value().size())));
+            words += 1 + entry.capacity / 8;
+            break;
+        }
+        entries.push_back(entry);
+    }
+
+    std::vector<Entry> entries;
+    std::string names;
+    uint32_t words{0};
+};
+
+/// Values of a tree laid out as the entries, checking that it has their shape
+struct Writer {
+    void write(const Property& prop)
+    {
+        if (next == count)
+            throw std::invalid_argument("Tree of another shape than the shared one");
+        const Entry& entry = entries[next++];
+        if (kindOf(prop) != entry.kind ||
+            prop.name().compare(0, std::string::npos, names + entry.name, entry.nameSize) != 0 ||
+            prop.displayName().compare(0, std::string::npos, names + entry.display, entry.displaySize) != 0 ||
+            !sameBounds(prop, entry))
+            throw std::invalid_argument("Tree of another shape than the shared one, at " + prop.name());
+
+        uint64_t* slot = words + entry.slot;
+        switch (entry.kind) {
+        case Kind::Group: {
+            const GroupProperty& group = prop.cast<GroupProperty>();
+            if (group.size() != entry.children)
+                throw std::invalid_argument("Tree of another shape than the shared one, at " + prop.name());
+            for (const Property& child : group)
+                write(child);
+            break;
+        }
+        case Kind::Bool:
+            *slot = word(prop.cast<BooleanProperty>().value());
+            break;
+        case Kind::Int:
+            *slot = word(prop.cast<IntProperty>().value());
+            break;
+        case Kind::Double:
+            *slot = word(prop.cast<DoubleProperty>().value());
+            break;
+        case Kind::String: {
+            const std::string& value = prop.cast<StringProperty>().value();
+            if (value.size() > entry.capacity)
+                throw std::length_error("String " + prop.name() + " longer than its " +
+                                        std::to_string(entry.capacity) + " shared bytes");
+            slot[0] = value.size();
+            // Bytes past the end are zeroed, so that equal strings have equal words
+            std::memset(slot + 1, 0, padded(value.size()));
+            std::memcpy(slot + 1, value.data(), value.size());
+            break;
+        }
+        }
+    }
+
+    /// Bounds are compared as values, both zeros being equal
+    static bool sameBounds(const Property& prop, const Entry& entry)
+    {
+        switch (entry.kind) {
+        case Kind::Int:
+            return word(prop.cast<IntProperty>().min()) == entry.min &&
+                   word(prop.cast<IntProperty>().max()) == entry.max;
+        case Kind::Double:
+            return prop.cast<DoubleProperty>().min() == real(entry.min) &&
+                   prop.cast<DoubleProperty>().max() == real(entry.max);
+        default:
+            return true;
+        }
+    }
+
+    const Entry* entries;
+    uint32_t count;
+    const char* names;
+    uint64_t* words;
+    uint32_t next{0};
+};
+
+Header& header(void* segment)
+{
+    return *static_cast<Header*>(segment);
+}
+
+const Header& header(const void* segment)
+{
+    return *static_cast<const Header*>(segment);
+}
+
+/// Values are shared as atomic words, so that the copies racing with a publication are well defined
+std::atomic<uint64_t>* values(const void* segment)
+{
+    return reinterpret_cast<std::atomic<uint64_t>*>(static_cast<char*>(const_cast<void*>(segment)) +
+                                                    header(segment).values);
+}
+
+const Entry* entries(const void* segment)
+{
+    return reinterpret_cast<const Entry*>(static_cast<const char*>(segment) + sizeof(Header));
+}
+
+/// Marks the segment published under name, if any, as retired: its readers learn that it is being replaced
+void retire(const std::string& name)
+{
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+        return;
+    struct stat status;
+    if (::fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(Header)) {
+        void* segment = ::mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (segment != MAP_FAILED) {
+            if (header(segment).magic.load(std::memory_order_acquire) == magic)
+                header(segment).retired.store(1, std::memory_order_release);
+            ::munmap(segment, sizeof(Header));
+        }
+    }
+    ::close(fd);
+}
+}
+
+SharedTreePublisher::SharedTreePublisher(const std::string& name, const Property& tree, size_t stringCapacity)
+    : name_{name}
+{
+    Layout layout;
+    layout.add(tree, stringCapacity);
+    const size_t names = sizeof(Header) + layout.entries.size() * sizeof(Entry);
+    const size_t values = padded(names + layout.names.size());
+    size_ = values + layout.words * sizeof(uint64_t);
+    if (size_ > std::numeric_limits<uint32_t>::max())
+        throw std::length_error("Tree too large to be shared");
+
+    // Readers of a previous segment keep it until they let it go
+    retire(name);
+    ::shm_unlink(name.c_str());
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+        fail("Cannot create the shared memory " + name);
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || ::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        errno = error;
+        fail("Cannot size the shared memory " + name);
+    }
+    device_ = static_cast<uint64_t>(status.st_dev);
+    inode_ = static_cast<uint64_t>(status.st_ino);
+    segment_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (segment_ == MAP_FAILED) {
+        ::shm_unlink(name.c_str());
+        errno = error;
+        fail("Cannot map the shared memory " + name);
+    }
+
+    // The segment starts zeroed, hence with sequence 0 and not retired
+    Header& head = header(segment_);
+    head.version = layoutVersion;
+    head.entries = static_cast<uint32_t>(layout.entries.size());
+    head.names = static_cast<uint32_t>(names);
+    head.values = static_cast<uint32_t>(values);
+    head.words = layout.words;
+    std::memcpy(static_cast<char*>(segment_) + sizeof(Header), layout.entries.data(), names - sizeof(Header));
+    std::memcpy(static_cast<char*>(segment_) + names, layout.names.data(), layout.names.size());
+    words_.assign(layout.words, 0);
+    publish(tree);
+    head.magic.store(magic, std::memory_order_release);
+}
+
+SharedTreePublisher::~SharedTreePublisher()
+{
+    header(segment_).retired.store(1, std::memory_order_release);
+    ::munmap(segment_, size_);
+
+    // The name is only removed if it was not taken over by a publisher replacing this one
+    const int fd = ::shm_open(name_.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return;
+    struct stat status;
+    const bool owned = ::fstat(fd, &status) == 0 && static_cast<uint64_t>(status.st_dev) == device_ &&
+                       static_cast<uint64_t>(status.st_ino) == inode_;
+    ::close(fd);
+    if (owned)
+        ::shm_unlink(name_.c_str());
+}
+
+void SharedTreePublisher::publish(const Property& tree)
+{
+    Header& head = header(segment_);
+    scratch_ = words_;
+    Writer writer{entries(segment_),
+                  head.entries,
+                  static_cast<const char*>(segment_) + head.names,
+                  scratch_.data()};
+    writer.write(tree);
+
+    // Sequence lock: readers which saw the odd value, or an older even one, try again
+    const uint64_t sequence = head.sequence.load(std::memory_order_relaxed);
+    head.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::atomic<uint64_t>* shared = values(segment_);
+    for (size_t i = 0; i < scratch_.size(); ++i) {
+        if (scratch_[i] != words_[i])
+            shared[i].store(scratch_[i], std::memory_order_relaxed);
+    }
+    head.sequence.store(sequence + 2, std::memory_order_release);
+    words_.swap(scratch_);
+}
+
+uint64_t SharedTreePublisher::version() const
+{
+    return header(segment_).sequence.load(std::memory_order_relaxed) / 2;
+}
+
+struct SharedTreeReader::Leaf {
+    Property* view;
+    const Entry* entry;
+};
+
+SharedTreeReader::SharedTreeReader(const std::string& name)
+{
+    const int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        fail("Cannot open the shared memory " + name);
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        fail("Cannot stat the shared memory " + name);
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    if (size_ < sizeof(Header)) {
+        ::close(fd);
+        throw std::invalid_argument("No shared tree in " + name);
+    }
+    void* segment = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (segment == MAP_FAILED) {
+        errno = error;
+        fail("Cannot map the shared memory " + name);
+    }
+    segment_ = segment;
+
+    // The layout is trusted once it is known to fit in the segment
+    const Header& head = header(segment_);
+    const bool valid = head.magic.load(std::memory_order_acquire) == magic && head.version == layoutVersion &&
+                       head.entries > 0 && head.names == sizeof(Header) + head.entries * sizeof(Entry) &&
+                       head.names <= head.values && head.values + uint64_t(head.words) * sizeof(uint64_t) <= size_;
+    try {
+        if (!valid)
+            throw std::invalid_argument("No shared tree in " + name);
+        words_.assign(head.words, 0);
+        sequence_ = snapshot();
+        if (!sequence_)
+            throw std::runtime_error("No consistent publication in " + name);
+        words_.swap(scratch_);
+        uint32_t entry = 0;
+        tree_ = build(entry);
+    } catch (...) {
+        ::munmap(const_cast<void*>(segment_), size_);
+        throw;
+    }
+}
+
+SharedTreeReader::~SharedTreeReader()
+{
+    ::munmap(const_cast<void*>(segment_), size_);
+}
+
+bool SharedTreeReader::retired() const
+{
+    return header(segment_).retired.load(std::memory_order_acquire) != 0;
+}
+
+bool SharedTreeReader::refresh()
+{
+    if (header(segment_).sequence.load(std::memory_order_acquire) == sequence_)
+        return false;
+    const uint64_t sequence = snapshot();
+    if (!sequence)
+        return false;
+    // Checked first, so that the view is either brought to the publication or left as is
+    for (const Leaf& leaf : leaves_) {
+        if (!inBounds(leaf))
+            throw std::out_of_range("Shared value of " + leaf.view->name() + " out of its bounds");
+    }
+    for (const Leaf& leaf : leaves_)
+        update(leaf);
+    words_.swap(scratch_);
+    sequence_ = sequence;
+    return true;
+}
+
+uint64_t SharedTreeReader::snapshot()
+{
+    const Header& head = header(segment_);
+    const std::atomic<uint64_t>* shared = values(segment_);
+    scratch_.resize(head.words);
+    for (unsigned attempt = 0; attempt < maxAttempts; ++attempt) {
+        const uint64_t before = head.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < scratch_.size(); ++i)
+            scratch_[i] = shared[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (head.sequence.load(std::memory_order_relaxed) == before)
+            return before;
+    }
+    return 0;
+}
+
+std::unique_ptr<Property> SharedTreeReader::build(uint32_t& index)
+{
+    const Header& head = header(segment_);
+    if (index >= head.entries)
+        throw std::invalid_argument("Corrupted shared tree");
+    const Entry& entry = entries(segment_)[index++];
+    const char* names = static_cast<const char*>(segment_) + head.names;
+    const uint64_t namesSize = head.values - head.names;
+    if (uint64_t(entry.name) + entry.nameSize > namesSize || uint64_t(entry.display) + entry.displaySize > namesSize ||
+        (entry.kind != Kind::Group &&
+         uint64_t(entry.slot) + 1 + (entry.kind == Kind::String ? entry.capacity / 8 : 0) > head.words))
+        throw std::invalid_argument("Corrupted shared tree");
+    const std::string name(names + entry.name, entry.nameSize);
+    const std::string display(names + entry.display, entry.displaySize);
+    const uint64_t* slot = words_.data() + entry.slot;
+
+    std::unique_ptr<Property> prop;
+    switch (entry.kind) {
+    case Kind::Group: {
+        std::vector<std::unique_ptr<Property>> children;
+        children.reserve(entry.children);
+        for (uint32_t i = 0; i < entry.children; ++i)
+            children.push_back(build(index));
+        return std::make_unique<OwnedGroupProperty>(name, display, std::move(children));
+    }
+    case Kind::Bool:
+        prop = std::make_unique<BooleanProperty>(name, *slot != 0, display);
+        break;
+    case Kind::Int:
+        prop = std::make_unique<IntProperty>(name,
+                                             static_cast<int>(static_cast<int64_t>(*slot)),
+                                             static_cast<int>(static_cast<int64_t>(entry.min)),
+                                             static_cast<int>(static_cast<int64_t>(entry.max)),
+                                             display);
+        break;
+    case Kind::Double:
+        prop = std::make_unique<DoubleProperty>(name, real(*slot), real(entry.min), real(entry.max), display);
+        break;
+    case Kind::String:
+        prop = std::make_unique<StringProperty>(
+            name, std::string(reinterpret_cast<const char*>(slot + 1), std::min<uint64_t>(slot[0], entry.capacity)),
+            display);
+        break;
+    default:
+        throw std::invalid_argument("Corrupted shared tree");
+    }
+    leaves_.push_back({prop.get(), &entry});
+    return prop;
+}
+
+bool SharedTreeReader::inBounds(const Leaf& leaf) const
+{
+    const uint64_t after = scratch_[leaf.entry->slot];
+    switch (leaf.entry->kind) {
+    case Kind::Int: {
+        const IntProperty& view = static_cast<const IntProperty&>(*leaf.view);
+        const int value = static_cast<int>(static_cast<int64_t>(after));
+        return value >= view.min() && value <= view.max();
+    }
+    case Kind::Double: {
+        const DoubleProperty& view = static_cast<const DoubleProperty&>(*leaf.view);
+        // As the property checks them, NaN passing
+        return !(real(after) < view.min()) && !(real(after) > view.max());
+    }
+    default:
+        return true;
+    }
+}
+
+void SharedTreeReader::update(const Leaf& leaf)
+{
+    const Entry& entry = *leaf.entry;
+    const uint64_t* before = words_.data() + entry.slot;
+    const uint64_t* after = scratch_.data() + entry.slot;
+    const size_t words = entry.kind == Kind::String ? 1 + padded(std::min<uint64_t>(after[0], entry.capacity)) / 8 : 1;
+    if (std::equal(after, after + words, before))
+        return;
+
+    switch (entry.kind) {
+    case Kind::Bool:
+        static_cast<BooleanProperty&>(*leaf.view) = *after != 0;
+        break;
+    case Kind::Int:
+        static_cast<IntProperty&>(*leaf.view) = static_cast<int>(static_cast<int64_t>(*after));
+        break;
+    case Kind::Double:
+        static_cast<DoubleProperty&>(*leaf.view) = real(*after);
+        break;
+    case Kind::String:
+        static_cast<StringProperty&>(*leaf.view) =
+            std::string(reinterpret_cast<const char*>(after + 1), std::min<uint64_t>(after[0], entry.capacity));
+        break;
+    case Kind::Group:
+        break;
+    }
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../property.h"
+#include "properties_export.h"
+
+#include <memory>
+#include <vector>
+
+namespace property
+{
+
+/// Publishes the values of a tree to other processes of the host, through a POSIX shared memory segment. The shape of
+/// the tree (names, display names, bounds and types) is laid out once; every publication then only writes the values
+/// which changed, under a sequence lock, so that readers never wait for the publisher nor see half of an update.
+///
+/// Only groups and boolean, integer, real and string properties can be published. Strings are given a fixed capacity
+/// when the segment is laid out. A tree of another shape needs another publisher, which replaces the segment.
+class PROPERTIES_EXPORT SharedTreePublisher
+{
+public:
+    /// Creates the segment with the given name (e.g. "/motors"), replacing any segment of that name (which is marked
+    /// as retired), and publishes the tree. Strings get stringCapacity bytes, or their current length if longer.
+    /// Throws std::system_error if the segment cannot be created, std::invalid_argument for a property of an
+    /// unsupported type.
+    SharedTreePublisher(const std::string& name, const Property& tree, size_t stringCapacity = 64);
+    SharedTreePublisher(const SharedTreePublisher&) = delete;
+    SharedTreePublisher& operator=(const SharedTreePublisher&) = delete;
+    /// Marks the segment as retired, for the readers to let it go, and removes its name unless another publisher
+    /// took it over
+    ~SharedTreePublisher();
+
+    /// Publishes the current values of the tree, which must have the shape it had at construction (display names and
+    /// bounds included), else std::invalid_argument is thrown. A string longer than its capacity throws
+    /// std::length_error. Nothing is published when an exception is thrown.
+    void publish(const Property& tree);
+
+    /// Number of publications so far, the first one included
+    uint64_t version() const;
+    const std::string& name() const { return name_; }
+
+private:
+    const std::string name_;
+    /// Identity of the segment, for the name to be removed only while it still designates it
+    uint64_t device_{0};
+    uint64_t inode_{0};
+    void* segment_{nullptr};
+    size_t size_{0};
+    /// Values published last, and being published
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> scratch_;
+};
+
+/// Read-only view, in another process, of a tree published by a SharedTreePublisher. The view is a tree of ordinary
+/// properties built once from the shape found in the segment; refresh() copies into it the values published since,
+/// assigning only the properties which changed, so that fingerprints, memoised outputs and change feeds of the view
+/// follow the publisher. Reading the segment never blocks the publisher.
+class PROPERTIES_EXPORT SharedTreeReader
+{
+public:
+    /// Maps the segment published under name. Throws std::system_error if there is none, std::invalid_argument if it
+    /// does not hold a published tree, std::runtime_error if no consistent publication could be read (the publisher
+    /// kept on writing, or died while writing).
+    explicit SharedTreeReader(const std::string& name);
+    SharedTreeReader(const SharedTreeReader&) = delete;
+    SharedTreeReader& operator=(const SharedTreeReader&) = delete;
+    ~SharedTreeReader();
+
+    /// Values are those of the last refresh(). The view must only be modified by refresh().
+    const Property& tree() const { return *tree_; }
+
+    /// Brings the view to the last publication. Returns false if there was none since the last refresh, or if the
+    /// publisher kept on writing (or died while writing) for as long as the reader retried. A value out of its bounds
+    /// (a damaged segment) throws std::out_of_range, the view being left as is.
+    bool refresh();
+
+    /// Version of the view, see SharedTreePublisher::version()
+    uint64_t version() const { return sequence_ / 2; }
+    /// Whether the publisher has gone, or was replaced by another one: nothing more is to be read in this segment
+    bool retired() const;
+
+private:
+    struct Leaf;
+
+    /// Copies the values of a consistent publication into scratch_, returns its sequence number or 0
+    uint64_t snapshot();
+    std::unique_ptr<Property> build(uint32_t& entry);
+    /// Whether the value read for a numeric leaf is within the bounds of its view
+    bool inBounds(const Leaf& leaf) const;
+    void update(const Leaf& leaf);
+
+private:
+    const void* segment_{nullptr};
+    size_t size_{0};
+    std::unique_ptr<Property> tree_;
+    std::vector<Leaf> leaves_;
+    /// Values of the view, and being read
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> scratch_;
+    uint64_t sequence_{0};
+};
+}
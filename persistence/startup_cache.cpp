@@ -0,0 +1,95 @@
+#include "startup_cache.h"
+
+#include "file_store.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace property
+{
+
+namespace
+{
+
+// Header of the images: magic, format version, then the hash and size of the source and the size of the tree
+const char magic[4] = {'P', 'R', 'P', 'I'};
+const uint32_t version = 1;
+const size_t headerSize = sizeof(magic) + sizeof(uint32_t) + 3 * sizeof(uint64_t);
+
+template <class T>
+void put(std::string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+T take(const char*& data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    data += sizeof(T);
+    return value;
+}
+}
+
+StartupCache::StartupCache(const std::string& imagePath, const JSONSerialiser& json, const BinarySerialiser& binary)
+    : imagePath_{imagePath}, json_{json}, binary_{binary}
+{
+}
+
+std::unique_ptr<Property> StartupCache::load(const char* data, size_t size)
+{
+    const uint64_t hash = Hasher().add(data, size).value();
+    std::unique_ptr<Property> prop = read(hash, size);
+    if (prop) {
+        ++hits_;
+        return prop;
+    }
+
+    ++misses_;
+    prop = json_.deserialise(data, size);
+    std::string image;
+    image.append(magic, sizeof(magic));
+    put(image, version);
+    put(image, hash);
+    put<uint64_t>(image, size);
+    put<uint64_t>(image, 0);
+    binary_.serialise(*prop, image);
+    const uint64_t treeSize = image.size() - headerSize;
+    std::memcpy(&image[headerSize - sizeof(uint64_t)], &treeSize, sizeof(uint64_t));
+    try {
+        writeAtomically(imagePath_, image);
+    } catch (const std::system_error&) {
+        // Only the next start is slower
+    }
+    return prop;
+}
+
+std::unique_ptr<Property> StartupCache::loadFile(const std::string& jsonPath)
+{
+    MappedFile file(jsonPath);
+    return load(file.data(), file.size());
+}
+
+std::unique_ptr<Property> StartupCache::read(uint64_t hash, uint64_t size) const
+{
+    try {
+        MappedFile file(imagePath_);
+        if (file.size() < headerSize || std::memcmp(file.data(), magic, sizeof(magic)) != 0)
+            return nullptr;
+        const char* data = file.data() + sizeof(magic);
+        if (take<uint32_t>(data) != version || take<uint64_t>(data) != hash || take<uint64_t>(data) != size)
+            return nullptr;
+        if (take<uint64_t>(data) != file.size() - headerSize)
+            return nullptr;
+        return binary_.deserialise(data, file.size() - headerSize);
+    } catch (const std::system_error&) {
+        // No image yet
+        return nullptr;
+    } catch (const std::exception&) {
+        // Damaged image, whose body may hold anything: truncated data, values out of their bounds, huge sizes
+        return nullptr;
+    }
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../serialisation/binary_serialiser.h"
+#include "../serialisation/json_serialiser.h"
+#include "properties_export.h"
+
+namespace property
+{
+
+/// Speeds up the repeated loading of the same JSON document: the first load parses it and writes the binary image of
+/// the tree to a local file, tagged with a hash of the JSON text; the following loads of the same text read the
+/// image instead of parsing. Images written from another text, by another format version or damaged are detected
+/// and rewritten.
+///
+/// Both serialisers must know the same group types. A failure to write the image is not an error, the next load
+/// parsing the JSON again.
+class PROPERTIES_EXPORT StartupCache
+{
+public:
+    StartupCache(const std::string& imagePath,
+                 const JSONSerialiser& json = JSONSerialiser::shared(),
+                 const BinarySerialiser& binary = BinarySerialiser::shared());
+    StartupCache(const StartupCache&) = delete;
+    StartupCache& operator=(const StartupCache&) = delete;
+
+    std::unique_ptr<Property> load(const char* data, size_t size);
+    std::unique_ptr<Property> load(const std::string& jsonString) { return load(jsonString.data(), jsonString.size()); }
+    /// Loads a JSON file through a memory mapping, throws std::system_error if it cannot be read
+    std::unique_ptr<Property> loadFile(const std::string& jsonPath);
+
+    /// Loads served from the image, and loads which parsed the JSON
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+    const std::string& imagePath() const { return imagePath_; }
+
+private:
+    /// The tree read from the image, or null if the image does not match the source
+    std::unique_ptr<Property> read(uint64_t hash, uint64_t size) const;
+
+private:
+    const std::string imagePath_;
+    const JSONSerialiser& json_;
+    const BinarySerialiser& binary_;
+    size_t hits_{0};
+    size_t misses_{0};
+};
+}
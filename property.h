@@ -1,13 +1,25 @@
 #pragma once
 
+#include "fingerprint.h"
 #include "properties_export.h"
 
+#include <atomic>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <typeinfo>
 
 namespace property
 {
 
+class ChangeFeed;
+class Property;
+
+/// Pushes the change of a property to the feed watching it
+PROPERTIES_EXPORT void publish(ChangeFeed& feed, const Property& prop);
+/// Unwatches a property being destroyed
+PROPERTIES_EXPORT void detach(ChangeFeed& feed, const Property& prop);
+
 namespace stream
 {
 template <class V>
@@ -42,14 +54,50 @@ PROPERTIES_EXPORT std::wostream& convert<std::string>(std::wostream& out, const
         return out;                                                                                                    \
     }
 
+/// Immutable metadata of a property, shared by all the properties built from the same descriptor. Sharing it saves
+/// the strings, not the bookkeeping: besides its value, each property holds a vtable pointer, the shared pointer to
+/// its descriptor and the parent and feed links, 40 bytes on 64-bit platforms.
+class Descriptor
+{
+public:
+    Descriptor(const std::string& name, const std::string& displayName = "")
+        : name_{name}, displayName_{displayName.empty() ? name : displayName}
+    {
+    }
+    virtual ~Descriptor() {}
+
+    const std::string& name() const { return name_; }
+    const std::string& displayName() const { return displayName_; }
+
+    /// Hash of the metadata, the same for equal descriptors
+    virtual uint64_t hash() const { return Hasher().add(name_).add(displayName_).value(); }
+    /// Whether rhs is a descriptor of the same type with the same metadata
+    virtual bool equals(const Descriptor& rhs) const
+    {
+        return typeid(*this) == typeid(rhs) && name_ == rhs.name_ && displayName_ == rhs.displayName_;
+    }
+
+private:
+    const std::string name_;
+    const std::string displayName_;
+};
+
 class Property
 {
 public:
     Property(const std::string& name, const std::string& displayName)
-        : name_{name}, displayName_{displayName.empty() ? name : displayName}
+        : descriptor_{std::make_shared<const Descriptor>(name, displayName)}
+    {
+    }
+    explicit Property(std::shared_ptr<const Descriptor> descriptor) : descriptor_{std::move(descriptor)} {}
+    /// A copy shares the descriptor of the original, but does not belong to its group
+    Property(const Property& rhs) : descriptor_{rhs.descriptor_} {}
+    virtual ~Property()
     {
+        ChangeFeed* feed = feed_.load(std::memory_order_acquire);
+        if (feed)
+            detach(*feed, *this);
     }
-    virtual ~Property() {}
 
     explicit operator std::string() const
     {
@@ -65,8 +113,18 @@ public:
     }
 
     virtual const std::string& id() const = 0;
-    const std::string& name() const { return name_; }
-    const std::string& displayName() const { return displayName_; }
+    /// Content hash of the type, name and value (but not the display name), combined over the children of groups.
+    /// Groups cache it until one of their descendants changes. By default the value is hashed in its string form,
+    /// which also holds the display name.
+    virtual uint64_t fingerprint() const { return header().add(static_cast<std::string>(*this)).value(); }
+    /// Deep equality of type, name and value, whatever the static types. By default the string forms are compared.
+    virtual bool equals(const Property& rhs) const
+    {
+        return !different(rhs) && static_cast<std::string>(*this) == static_cast<std::string>(rhs);
+    }
+    const std::string& name() const { return descriptor_->name(); }
+    const std::string& displayName() const { return descriptor_->displayName(); }
+    const std::shared_ptr<const Descriptor>& descriptor() const { return descriptor_; }
 
     template <class T>
     T& cast()
@@ -81,18 +139,51 @@ public:
 
     virtual std::ostream& str(std::ostream& out) const
     {
-        out << displayName_;
+        out << displayName();
         return out;
     }
-    virtual std::wostream& str(std::wostream& out) const { return stream::convert(out, displayName_); }
+    virtual std::wostream& str(std::wostream& out) const { return stream::convert(out, displayName()); }
 
 protected:
+    friend class ChangeFeed;
+    friend class GroupProperty;
+
     /// Returns true if the types and names don't match
-    bool different(const Property& rhs) const { return id() != rhs.id() || name_ != rhs.name_; }
+    bool different(const Property& rhs) const
+    {
+        return id() != rhs.id() || (descriptor_ != rhs.descriptor_ && name() != rhs.name());
+    }
+    /// Hasher already fed with the type and name
+    Hasher header() const { return Hasher().add(id()).add(name()); }
 
-protected:
-    const std::string name_;
-    const std::string displayName_;
+    /// To be called once the value has changed: notifies the feed watching the property, if any, and invalidates
+    /// what the enclosing groups cached about it
+    void changed() const
+    {
+        ChangeFeed* feed = feed_.load(std::memory_order_acquire);
+        if (feed)
+            publish(*feed, *this);
+        const Property* parent = parent_.load(std::memory_order_relaxed);
+        if (parent)
+            parent->childChanged(*this);
+        for (; parent && parent->invalidate(); parent = parent->parent_.load(std::memory_order_relaxed)) {
+        }
+    }
+    /// Called on the group which adopted the child when the value of the child changed, before invalidate()
+    virtual void childChanged(const Property& /*child*/) const {}
+    /// Drops the cached state, returns false if there was none (hence none in the enclosing groups either)
+    virtual bool invalidate() const { return false; }
+
+    /// For derived classes whose metadata changes on assignment: the descriptor is replaced, never modified in place
+    void setDescriptor(std::shared_ptr<const Descriptor> descriptor) { descriptor_ = std::move(descriptor); }
+
+private:
+    std::shared_ptr<const Descriptor> descriptor_;
+    /// Group which last cached state about this property, set by the group itself. Atomic since readers of the tree
+    /// on several threads may fingerprint the same group at once, all of them storing the same parent.
+    mutable std::atomic<const Property*> parent_{nullptr};
+    /// Feed watching this property, set by the feed itself
+    mutable std::atomic<ChangeFeed*> feed_{nullptr};
 };
 
 inline std::ostream& operator<<(std::ostream& out, const Property& prop)
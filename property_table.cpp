@@ -0,0 +1,249 @@
+#include "property_table.h"
+
+#include "basic_property.h"
+#include "numeric_property.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+namespace property
+{
+
+namespace
+{
+
+/// Value of a numeric property, checked against the bounds of the field as the field's own operator= would
+template <class T>
+typename T::value_type bounded(const Property& field, const Property& prop)
+{
+    const T& bounds = field.cast<T>();
+    const typename T::value_type value = prop.cast<T>().value();
+    if (value < bounds.min())
+        throw std::out_of_range("Min value was not respected");
+    if (value > bounds.max())
+        throw std::out_of_range("Max value was not respected");
+    return value;
+}
+}
+
+PropertyTable::Row::Row(const PropertyTable& table, PropertyTable* writable, size_t index)
+    : GroupProperty(table.name_, table.displayName_), table_{table}, writable_{writable}, index_{index}
+{
+    children_.reserve(table.columns());
+    pointers_.reserve(table.columns());
+    for (size_t column = 0; column < table.columns(); ++column) {
+        children_.push_back(table.cell(column, index));
+        pointers_.push_back(children_.back().get());
+        adopt(*children_.back());
+    }
+}
+
+PropertyTable::Row::Row(const Row& rhs) : Row(rhs.table_, rhs.writable_, rhs.index_) {}
+
+void PropertyTable::Row::childChanged(const Property& child) const
+{
+    if (!writable_)
+        return;
+    const size_t column = std::find(pointers_.begin(), pointers_.end(), &child) - pointers_.begin();
+    if (column >= pointers_.size())
+        return;
+    try {
+        writable_->store(column, index_, child);
+    } catch (const std::out_of_range&) {
+        // The cell took the value (and bounds) of another property in its own operator= before telling the row:
+        // store() checks the field's bounds before writing, so the column is intact and the cell gets its value back
+        Property& cell = *children_[column];
+        if (table_.kind(column) == Kind::Int)
+            cell.cast<IntProperty>() = table_.cell(column, index_)->cast<IntProperty>();
+        else
+            cell.cast<DoubleProperty>() = table_.cell(column, index_)->cast<DoubleProperty>();
+        throw;
+    }
+}
+
+PropertyTable::PropertyTable(const GroupProperty& prototype)
+    : name_{prototype.name()}, displayName_{prototype.displayName()}
+{
+    columns_.reserve(prototype.size());
+    for (const Property& field : prototype) {
+        Column column;
+        if (field.id() == BooleanProperty::identifier) {
+            column.kind = Kind::Bool;
+            column.prototype = std::make_unique<BooleanProperty>(field.cast<BooleanProperty>());
+        } else if (field.id() == IntProperty::identifier) {
+            column.kind = Kind::Int;
+            column.prototype = std::make_unique<IntProperty>(field.cast<IntProperty>());
+        } else if (field.id() == DoubleProperty::identifier) {
+            column.kind = Kind::Double;
+            column.prototype = std::make_unique<DoubleProperty>(field.cast<DoubleProperty>());
+        } else if (field.id() == StringProperty::identifier) {
+            column.kind = Kind::String;
+            column.prototype = std::make_unique<StringProperty>(field.cast<StringProperty>());
+        } else {
+            throw std::invalid_argument("Cannot store a property of type " + field.id() + " in a table");
+        }
+        columns_.push_back(std::move(column));
+    }
+}
+
+void PropertyTable::reserve(size_t rows)
+{
+    for (Column& column : columns_) {
+        switch (column.kind) {
+        case Kind::Bool:
+            column.booleans.reserve(rows);
+            break;
+        case Kind::Int:
+            column.integers.reserve(rows);
+            break;
+        case Kind::Double:
+            column.reals.reserve(rows);
+            break;
+        case Kind::String:
+            column.strings.reserve(rows);
+            break;
+        }
+    }
+}
+
+size_t PropertyTable::append()
+{
+    for (Column& column : columns_) {
+        switch (column.kind) {
+        case Kind::Bool:
+            column.booleans.push_back(column.prototype->cast<BooleanProperty>().value());
+            break;
+        case Kind::Int:
+            column.integers.push_back(column.prototype->cast<IntProperty>().value());
+            break;
+        case Kind::Double:
+            column.reals.push_back(column.prototype->cast<DoubleProperty>().value());
+            break;
+        case Kind::String:
+            column.strings.push_back(column.prototype->cast<StringProperty>().value());
+            break;
+        }
+    }
+    return size_++;
+}
+
+size_t PropertyTable::append(const GroupProperty& row)
+{
+    // Look every field up first, so that a failure leaves the table unchanged
+    std::vector<const Property*> fields;
+    fields.reserve(columns_.size());
+    for (const Column& column : columns_)
+        fields.push_back(&row.get<Property>(column.prototype->name()));
+
+    const size_t index = append();
+    try {
+        for (size_t column = 0; column < columns_.size(); ++column)
+            store(column, index, *fields[column]);
+    } catch (...) {
+        --size_;
+        for (Column& column : columns_) {
+            switch (column.kind) {
+            case Kind::Bool:
+                column.booleans.pop_back();
+                break;
+            case Kind::Int:
+                column.integers.pop_back();
+                break;
+            case Kind::Double:
+                column.reals.pop_back();
+                break;
+            case Kind::String:
+                column.strings.pop_back();
+                break;
+            }
+        }
+        throw;
+    }
+    return index;
+}
+
+PropertyTable::Row PropertyTable::row(size_t index)
+{
+    if (index >= size_)
+        throw std::out_of_range("No row " + std::to_string(index) + " in a table of " + std::to_string(size_));
+    return Row(*this, this, index);
+}
+
+PropertyTable::Row PropertyTable::row(size_t index) const
+{
+    if (index >= size_)
+        throw std::out_of_range("No row " + std::to_string(index) + " in a table of " + std::to_string(size_));
+    return Row(*this, nullptr, index);
+}
+
+size_t PropertyTable::column(const std::string& name) const
+{
+    for (size_t column = 0; column < columns_.size(); ++column) {
+        if (columns_[column].prototype->name() == name)
+            return column;
+    }
+    throw std::out_of_range("No column with name: " + name);
+}
+
+void PropertyTable::clamp(size_t column)
+{
+    Column& values = columns_.at(column);
+    if (values.kind == Kind::Int) {
+        const IntProperty& field = values.prototype->cast<IntProperty>();
+        const int min = field.min();
+        const int max = field.max();
+        for (int& value : values.integers)
+            value = std::min(std::max(value, min), max);
+    } else if (values.kind == Kind::Double) {
+        const DoubleProperty& field = values.prototype->cast<DoubleProperty>();
+        const double min = field.min();
+        const double max = field.max();
+        for (double& value : values.reals)
+            value = std::min(std::max(value, min), max);
+    }
+}
+
+const PropertyTable::Column& PropertyTable::typed(size_t column, Kind kind) const
+{
+    const Column& values = columns_.at(column);
+    if (values.kind != kind)
+        throw std::bad_cast();
+    return values;
+}
+
+std::unique_ptr<Property> PropertyTable::cell(size_t column, size_t index) const
+{
+    const Column& values = columns_[column];
+    const Property& field = *values.prototype;
+    switch (values.kind) {
+    case Kind::Bool:
+        return std::make_unique<BooleanProperty>(field.descriptor(), values.booleans[index] != 0);
+    case Kind::Int:
+        return std::make_unique<IntProperty>(field.cast<IntProperty>().descriptor(), values.integers[index]);
+    case Kind::Double:
+        return std::make_unique<DoubleProperty>(field.cast<DoubleProperty>().descriptor(), values.reals[index]);
+    case Kind::String:
+        return std::make_unique<StringProperty>(field.descriptor(), values.strings[index]);
+    }
+    return nullptr;
+}
+
+void PropertyTable::store(size_t column, size_t index, const Property& prop)
+{
+    Column& values = columns_[column];
+    switch (values.kind) {
+    case Kind::Bool:
+        values.booleans[index] = prop.cast<BooleanProperty>().value();
+        break;
+    case Kind::Int:
+        values.integers[index] = bounded<IntProperty>(*values.prototype, prop);
+        break;
+    case Kind::Double:
+        values.reals[index] = bounded<DoubleProperty>(*values.prototype, prop);
+        break;
+    case Kind::String:
+        values.strings[index] = prop.cast<StringProperty>().value();
+        break;
+    }
+}
+}
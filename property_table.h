@@ -0,0 +1,125 @@
+#pragma once
+
+#include "group_property.h"
+#include "properties_export.h"
+
+#include <memory>
+#include <vector>
+
+namespace property
+{
+
+/// Many records of the same schema, stored as one column per field instead of one group per record. The schema is
+/// taken once from a prototype group whose children are boolean, integer, real or string properties; the names,
+/// display names and bounds of the fields live in the schema only, and the columns hold nothing but values.
+///
+/// Columns are exposed as plain arrays for loops over a whole field. Writes through them bypass the bounds, which
+/// clamp() applies again afterwards.
+class PROPERTIES_EXPORT PropertyTable
+{
+public:
+    enum class Kind : unsigned char { Bool, Int, Double, String };
+
+    /// View of one record as a group. Its children are built from the table when the view is made; assigning them
+    /// (e.g. through an Accessor) writes the new values back into the table. Views refer to their table, which must
+    /// outlive them and keep its address.
+    class PROPERTIES_EXPORT Row : public GroupProperty
+    {
+    public:
+        Row(const Row& rhs);
+        ~Row() override {}
+
+        GroupPropertyIterator begin() const override { return GroupPropertyIterator{pointers_.data(), 0, size()}; }
+        GroupPropertyIterator end() const override { return GroupPropertyIterator{pointers_.data(), size(), size()}; }
+        size_t size() const override { return pointers_.size(); }
+        bool fixedLayout() const override { return true; }
+        /// Views of a const table cannot be written through
+        bool writable() const override { return writable_ != nullptr; }
+
+        size_t index() const { return index_; }
+
+    protected:
+        /// Stores the value of the changed child back into its column. If the value is out of the bounds of the
+        /// column, the child is given back the value of the column before std::out_of_range is rethrown.
+        void childChanged(const Property& child) const override;
+
+    private:
+        friend class PropertyTable;
+        Row(const PropertyTable& table, PropertyTable* writable, size_t index);
+
+        const PropertyTable& table_;
+        /// Null for views of a const table
+        PropertyTable* const writable_;
+        const size_t index_;
+        std::vector<std::unique_ptr<Property>> children_;
+        std::vector<const Property*> pointers_;
+    };
+
+    /// Throws std::invalid_argument if a child of the prototype is of another type than the supported ones
+    explicit PropertyTable(const GroupProperty& prototype);
+    PropertyTable(PropertyTable&&) = default;
+    PropertyTable& operator=(PropertyTable&&) = default;
+
+    /// Name and display name of the rows
+    const std::string& name() const { return name_; }
+    const std::string& displayName() const { return displayName_; }
+
+    /// Number of rows
+    size_t size() const { return size_; }
+    void reserve(size_t rows);
+    /// Appends a row with the values of the prototype
+    size_t append();
+    /// Appends a row copied from a group of the schema, whose children are found by name. Throws std::out_of_range
+    /// for a missing child or a value out of bounds, and std::bad_cast for a child of the wrong type.
+    size_t append(const GroupProperty& row);
+
+    /// Throws std::out_of_range past the last row
+    Row row(size_t index);
+    Row row(size_t index) const;
+
+    size_t columns() const { return columns_.size(); }
+    /// Position of the column with the given name, throws std::out_of_range if there is none
+    size_t column(const std::string& name) const;
+    Kind kind(size_t column) const { return columns_.at(column).kind; }
+    /// Prototype of the field, with its name, display name, bounds and default value
+    const Property& schema(size_t column) const { return *columns_.at(column).prototype; }
+
+    /// Values of a column, size() of them. Throws std::bad_cast if the column is of another kind.
+    unsigned char* booleans(size_t column) { return typed(column, Kind::Bool).booleans.data(); }
+    const unsigned char* booleans(size_t column) const { return typed(column, Kind::Bool).booleans.data(); }
+    int* integers(size_t column) { return typed(column, Kind::Int).integers.data(); }
+    const int* integers(size_t column) const { return typed(column, Kind::Int).integers.data(); }
+    double* reals(size_t column) { return typed(column, Kind::Double).reals.data(); }
+    const double* reals(size_t column) const { return typed(column, Kind::Double).reals.data(); }
+    std::string* strings(size_t column) { return typed(column, Kind::String).strings.data(); }
+    const std::string* strings(size_t column) const { return typed(column, Kind::String).strings.data(); }
+
+    /// Brings the values of a numeric column back within the bounds of its field
+    void clamp(size_t column);
+
+private:
+    struct Column {
+        std::unique_ptr<Property> prototype;
+        Kind kind;
+        std::vector<unsigned char> booleans;
+        std::vector<int> integers;
+        std::vector<double> reals;
+        std::vector<std::string> strings;
+    };
+
+    const Column& typed(size_t column, Kind kind) const;
+    Column& typed(size_t column, Kind kind)
+    {
+        return const_cast<Column&>(static_cast<const PropertyTable*>(this)->typed(column, kind));
+    }
+    /// Property holding the value of one cell, named after its field
+    std::unique_ptr<Property> cell(size_t column, size_t index) const;
+    void store(size_t column, size_t index, const Property& prop);
+
+private:
+    std::string name_;
+    std::string displayName_;
+    std::vector<Column> columns_;
+    size_t size_{0};
+};
+}
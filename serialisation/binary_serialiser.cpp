@@ -0,0 +1,363 @@
+#include "binary_serialiser.h"
+
+#include "interner.h"
+#include "owned_group_property.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace property
+{
+
+namespace
+{
+
+const char stringTag = 's';
+const char boolTag = 'b';
+const char intTag = 'i';
+const char doubleTag = 'd';
+const char groupTag = 'g';
+
+const std::string& identifierOf(char tag)
+{
+    switch (tag) {
+    case stringTag:
+        return StringProperty::identifier;
+    case boolTag:
+        return BooleanProperty::identifier;
+    case intTag:
+        return IntProperty::identifier;
+    case doubleTag:
+        return DoubleProperty::identifier;
+    case groupTag:
+        return GroupProperty::identifier;
+    }
+    throw std::runtime_error("Unknown binary property tag: " + std::to_string(int(tag)));
+}
+
+/// Bounds present after a numeric value
+enum Bounds : unsigned char { HasMin = 1, HasMax = 2 };
+
+void writeVarint(std::string& out, unsigned long long value)
+{
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void writeString(std::string& out, const std::string& value)
+{
+    writeVarint(out, value.size());
+    out += value;
+}
+
+/// Bounds-checked reading of an encoded property
+struct BinaryCursor {
+    const char* pos_;
+    const char* end_;
+
+    void require(size_t size) const
+    {
+        if (static_cast<size_t>(end_ - pos_) < size)
+            throw std::runtime_error("Truncated binary property");
+    }
+    char byte()
+    {
+        require(1);
+        return *pos_++;
+    }
+    unsigned long long varint()
+    {
+        unsigned long long value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const unsigned char c = byte();
+            value |= static_cast<unsigned long long>(c & 0x7F) << shift;
+            if (!(c & 0x80))
+                return value;
+        }
+        throw std::runtime_error("Malformed binary varint");
+    }
+    const char* bytes(size_t size)
+    {
+        require(size);
+        const char* begin = pos_;
+        pos_ += size;
+        return begin;
+    }
+    std::string string()
+    {
+        const size_t size = varint();
+        return std::string(bytes(size), size);
+    }
+    uint32_t size32()
+    {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(bytes(4));
+        return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24);
+    }
+};
+
+template <class V>
+struct BinaryValue;
+
+template <>
+struct BinaryValue<bool> {
+    static void write(std::string& out, bool value) { out += value ? '\1' : '\0'; }
+    static bool read(BinaryCursor& in) { return in.byte() != 0; }
+};
+template <>
+struct BinaryValue<std::string> {
+    static void write(std::string& out, const std::string& value) { writeString(out, value); }
+    static std::string read(BinaryCursor& in) { return in.string(); }
+};
+template <>
+struct BinaryValue<int> {
+    // Zigzag encoding keeps small negative values short
+    static void write(std::string& out, int value)
+    {
+        writeVarint(out, (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 31));
+    }
+    static int read(BinaryCursor& in)
+    {
+        const unsigned long long value = in.varint();
+        return static_cast<int>((value >> 1) ^ (0 - (value & 1)));
+    }
+};
+template <>
+struct BinaryValue<double> {
+    static void write(std::string& out, double value)
+    {
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, &value, sizeof(double));
+        out.append(bytes, sizeof(double));
+    }
+    static double read(BinaryCursor& in)
+    {
+        double value;
+        std::memcpy(&value, in.bytes(sizeof(double)), sizeof(double));
+        return value;
+    }
+};
+}
+
+/// Header of an encoded property, its body being read by the serialiser of its type
+struct BinaryNode : public Node {
+    BinaryNode(const char* data, const char* end, Interner* descriptors = nullptr)
+        : body_{data, end}, descriptors_{descriptors}
+    {
+        tag_ = body_.byte();
+        name_ = body_.string();
+        display_ = body_.string();
+    }
+
+    const std::string& id() const override { return identifierOf(tag_); }
+    const std::string& name() const override { return name_; }
+    const std::string& displayName() const override { return display_; }
+
+    std::unique_ptr<Node> child(const std::string& name, size_t /*position*/) const override
+    {
+        if (tag_ != groupTag)
+            return nullptr;
+        BinaryCursor in = body_;
+        for (size_t count = in.varint(); count > 0; --count) {
+            const size_t size = in.size32();
+            const char* begin = in.bytes(size);
+            auto child = std::make_unique<BinaryNode>(begin, begin + size, descriptors_);
+            if (child->name_ == name)
+                return std::move(child);
+        }
+        return nullptr;
+    }
+
+    /// Descriptor built from args, shared with the other nodes of the data describing the same
+    template <class D, class... Args>
+    std::shared_ptr<const D> describe(Args&&... args) const
+    {
+        auto descriptor = std::make_shared<const D>(std::forward<Args>(args)...);
+        return descriptors_ ? descriptors_->intern(std::move(descriptor)) : descriptor;
+    }
+
+    char tag_;
+    std::string name_;
+    /// Empty when equal to the name
+    std::string display_;
+    /// Type-specific content
+    BinaryCursor body_;
+    /// Shares the descriptors of the leaves below this node, if set
+    Interner* descriptors_;
+};
+
+struct BinaryOutput : public Output {
+    explicit BinaryOutput(std::string& out) : out_{out} {}
+
+    std::string& out_;
+};
+
+class BinaryPropertySerialiser : public PropertySerialiser
+{
+public:
+    explicit BinaryPropertySerialiser(char tag) : tag_{tag} {}
+
+private:
+    void serialise(Output& raw, const Property& prop) const override
+    {
+        std::string& out = raw.cast<BinaryOutput>().out_;
+        out += tag_;
+        writeString(out, prop.name());
+        writeString(out, prop.displayName() == prop.name() ? std::string() : prop.displayName());
+        serialiseBody(out, prop);
+    }
+
+    virtual void serialiseBody(std::string& out, const Property& prop) const = 0;
+
+private:
+    const char tag_;
+};
+
+template <class T, char Tag>
+class BinaryBasicSerialiser : public BinaryPropertySerialiser
+{
+public:
+    using value_type = T;
+
+    BinaryBasicSerialiser() : BinaryPropertySerialiser(Tag) {}
+
+    std::unique_ptr<Property> deserialise(const Node& raw) const override
+    {
+        const BinaryNode& node = raw.cast<BinaryNode>();
+        BinaryCursor in = node.body_;
+        return std::make_unique<T>(node.describe<Descriptor>(node.name(), node.displayName()),
+                                   BinaryValue<typename T::value_type>::read(in));
+    }
+
+    void serialiseBody(std::string& out, const Property& prop) const override
+    {
+        BinaryValue<typename T::value_type>::write(out, prop.cast<value_type>().value());
+    }
+};
+
+template <class T, char Tag>
+class BinaryNumericSerialiser : public BinaryPropertySerialiser
+{
+public:
+    using value_type = T;
+    using V = typename T::value_type;
+
+    BinaryNumericSerialiser() : BinaryPropertySerialiser(Tag) {}
+
+    std::unique_ptr<Property> deserialise(const Node& raw) const override
+    {
+        const BinaryNode& node = raw.cast<BinaryNode>();
+        BinaryCursor in = node.body_;
+        const unsigned char bounds = in.byte();
+        const V value = BinaryValue<V>::read(in);
+        const V min = bounds & HasMin ? BinaryValue<V>::read(in) : V(-T::max_value);
+        const V max = bounds & HasMax ? BinaryValue<V>::read(in) : V(T::max_value);
+        return std::make_unique<T>(
+            node.describe<typename T::Descriptor>(node.name(), min, max, node.displayName()), value);
+    }
+
+    void serialiseBody(std::string& out, const Property& prop) const override
+    {
+        const T& numeric = prop.cast<value_type>();
+        const bool hasMin = numeric.min() != -value_type::max_value;
+        const bool hasMax = numeric.max() != value_type::max_value;
+        out += static_cast<char>((hasMin ? HasMin : 0) | (hasMax ? HasMax : 0));
+        BinaryValue<V>::write(out, numeric.value());
+        if (hasMin)
+            BinaryValue<V>::write(out, numeric.min());
+        if (hasMax)
+            BinaryValue<V>::write(out, numeric.max());
+    }
+};
+
+class BinaryGroupSerialiser : public BinaryPropertySerialiser
+{
+public:
+    using value_type = GroupProperty;
+
+    BinaryGroupSerialiser(std::function<std::unique_ptr<Property>(const Node& node)> deserialiseChild,
+                          std::function<void(Output& out, const Property& prop)> serialiseChild)
+        : BinaryPropertySerialiser(groupTag), deserialiseChild_{deserialiseChild}, serialiseChild_{serialiseChild}
+    {
+    }
+
+    std::unique_ptr<Property> deserialise(const Node& raw) const override
+    {
+        const BinaryNode& node = raw.cast<BinaryNode>();
+        BinaryCursor in = node.body_;
+        // Every child takes at least the 4 bytes of its size, so that a larger count is not allocated
+        const unsigned long long count = in.varint();
+        if (count > static_cast<size_t>(in.end_ - in.pos_) / 4)
+            throw std::runtime_error("Truncated binary property");
+        std::vector<std::unique_ptr<Property>> children(count);
+        for (auto& child : children) {
+            const size_t size = in.size32();
+            const char* begin = in.bytes(size);
+            child = deserialiseChild_(BinaryNode(begin, begin + size, node.descriptors_));
+        }
+        return std::make_unique<OwnedGroupProperty>(node.name(), node.displayName(), std::move(children));
+    }
+
+    void serialiseBody(std::string& out, const Property& prop) const override
+    {
+        const value_type& group = prop.cast<value_type>();
+        writeVarint(out, group.size());
+        for (const Property& child : group) {
+            // The size is patched once the child is written, so that readers can skip it
+            const size_t start = out.size();
+            out.append(4, '\0');
+            BinaryOutput childOut(out);
+            serialiseChild_(childOut, child);
+            const uint32_t size = static_cast<uint32_t>(out.size() - start - 4);
+            for (int i = 0; i < 4; ++i)
+                out[start + i] = static_cast<char>(size >> (8 * i));
+        }
+    }
+
+private:
+    std::function<std::unique_ptr<Property>(const Node& node)> deserialiseChild_;
+    std::function<void(Output& out, const Property& prop)> serialiseChild_;
+};
+
+BinarySerialiser::BinarySerialiser()
+    : Serialiser(Mapper<BinaryBasicSerialiser<StringProperty, stringTag>,
+                        BinaryBasicSerialiser<BooleanProperty, boolTag>,
+                        BinaryNumericSerialiser<IntProperty, intTag>,
+                        BinaryNumericSerialiser<DoubleProperty, doubleTag>,
+                        BinaryGroupSerialiser>())
+{
+}
+
+const BinarySerialiser& BinarySerialiser::shared()
+{
+    static const BinarySerialiser serialiser;
+    return serialiser;
+}
+
+std::string BinarySerialiser::serialise(const Property& prop) const
+{
+    std::string out;
+    serialise(prop, out);
+    return out;
+}
+
+void BinarySerialiser::serialise(const Property& prop, std::string& out) const
+{
+    BinaryOutput output{out};
+    serialiseNode(output, prop);
+}
+
+std::unique_ptr<Property> BinarySerialiser::deserialise(const char* data, size_t size) const
+{
+    Interner descriptors;
+    return deserialiseNode(BinaryNode(data, data + size, &descriptors));
+}
+
+std::unique_ptr<Property> BinarySerialiser::deserialise(const char* data, size_t size, const std::type_index& type) const
+{
+    Interner descriptors;
+    return deserialiseNode(BinaryNode(data, data + size, &descriptors), type);
+}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "properties_export.h"
+#include "serialiser.h"
+
+namespace property
+{
+
+/// Compact binary encoding of properties: a type tag, length-prefixed names, varint or raw IEEE values and
+/// size-prefixed group children. Not meant to be exchanged between platforms of different endianness.
+class PROPERTIES_EXPORT BinarySerialiser : public Serialiser
+{
+public:
+    BinarySerialiser();
+
+    /// Instance without registered groups, shared by the whole process
+    static const BinarySerialiser& shared();
+
+    std::string serialise(const Property& prop) const;
+    /// Appends the encoded property to out
+    void serialise(const Property& prop, std::string& out) const;
+    /// Throws std::runtime_error if the data is truncated or malformed
+    std::unique_ptr<Property> deserialise(const char* data, size_t size) const;
+    std::unique_ptr<Property> deserialise(const std::string& data) const
+    {
+        return deserialise(data.data(), data.size());
+    }
+
+    template <class T>
+    std::unique_ptr<T> deserialise(const std::string& data) const
+    {
+        return downcast<T>(deserialise(data.data(), data.size(), std::type_index(typeid(T))));
+    }
+
+private:
+    std::unique_ptr<Property> deserialise(const char* data, size_t size, const std::type_index& type) const;
+};
+}
@@ -0,0 +1,60 @@
+#include "interner.h"
+
+#include "../group_property.h"
+
+namespace property
+{
+
+namespace
+{
+
+/// As equals, but also comparing the display names, which identical instances must share too. The fingerprints
+/// (cached by groups) are compared first, so that only likely matches are walked.
+bool identical(const Property& lhs, const Property& rhs)
+{
+    if (&lhs == &rhs)
+        return true;
+    if (lhs.fingerprint() != rhs.fingerprint() || lhs.displayName() != rhs.displayName())
+        return false;
+    const GroupProperty* left = dynamic_cast<const GroupProperty*>(&lhs);
+    if (!left)
+        return lhs.equals(rhs);
+    // Children are compared here rather than by equals, which would walk the subtree once more at each level
+    const GroupProperty* right = dynamic_cast<const GroupProperty*>(&rhs);
+    if (!right || left->id() != right->id() || left->name() != right->name() || left->size() != right->size())
+        return false;
+    for (auto it = left->begin(), jt = right->begin(); it != left->end(); ++it, ++jt) {
+        if (!identical(*it, *jt))
+            return false;
+    }
+    return true;
+}
+}
+
+std::shared_ptr<const Property> Interner::intern(std::unique_ptr<Property> prop)
+{
+    const uint64_t fingerprint = prop->fingerprint();
+    auto range = instances_.equal_range(fingerprint);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (identical(*it->second, *prop)) {
+            ++hits_;
+            return it->second;
+        }
+    }
+    std::shared_ptr<const Property> instance(std::move(prop));
+    instances_.emplace(fingerprint, instance);
+    return instance;
+}
+
+std::shared_ptr<const Descriptor> Interner::share(std::shared_ptr<const Descriptor> descriptor)
+{
+    const uint64_t hash = descriptor->hash();
+    auto range = descriptors_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->equals(*descriptor))
+            return it->second;
+    }
+    descriptors_.emplace(hash, descriptor);
+    return descriptor;
+}
+}
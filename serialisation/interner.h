@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../property.h"
+#include "properties_export.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace property
+{
+
+/// Hash-consing of properties: structurally identical ones (same types, names, display names and values, down to
+/// the leaves) are replaced by a single shared instance. The shared instances must then be treated as immutable.
+/// Descriptors are interned apart, for the deserialisers to share them between the properties of one field.
+class PROPERTIES_EXPORT Interner
+{
+public:
+    /// The instance identical to prop if one was interned before, else prop itself
+    std::shared_ptr<const Property> intern(std::unique_ptr<Property> prop);
+    /// The descriptor equal to descriptor if one was interned before, else descriptor itself
+    template <class D>
+    std::shared_ptr<const D> intern(std::shared_ptr<const D> descriptor)
+    {
+        return std::static_pointer_cast<const D>(share(std::move(descriptor)));
+    }
+
+    /// Number of distinct instances
+    size_t size() const { return instances_.size(); }
+    /// Number of properties replaced by an existing instance
+    size_t hits() const { return hits_; }
+
+private:
+    std::shared_ptr<const Descriptor> share(std::shared_ptr<const Descriptor> descriptor);
+
+private:
+    std::unordered_multimap<uint64_t, std::shared_ptr<const Property>> instances_;
+    std::unordered_multimap<uint64_t, std::shared_ptr<const Descriptor>> descriptors_;
+    size_t hits_{0};
+};
+}
@@ -0,0 +1,326 @@
+#include "json_push_parser.h"
+
+#include "json_scanner.h"
+#include "owned_group_property.h"
+
+#include <nlohmann/json.hpp>
+using json = nlohmann::json;
+
+namespace property
+{
+
+namespace
+{
+
+bool delimiter(char c)
+{
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case '"':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Optional string member, empty if missing
+const std::string& text(const json& members, const char* key)
+{
+    static const std::string none;
+    auto it = members.find(key);
+    return it != members.end() && it->is_string() ? it->get_ref<const std::string&>() : none;
+}
+}
+
+struct JSONPushParser::Frame {
+    explicit Frame(bool object) : object{object} {}
+
+    bool object;
+    /// Members of an object, but its children
+    json members = json::object();
+    bool hasChildren{false};
+    /// Children of a group, collected by the array holding them
+    std::vector<std::unique_ptr<Property>> children;
+};
+
+JSONPushParser::JSONPushParser(const JSONSerialiser& serialiser, size_t maxToken)
+    : serialiser_{serialiser}, maxToken_{maxToken}
+{
+}
+
+JSONPushParser::~JSONPushParser() {}
+
+size_t JSONPushParser::feed(const char* data, size_t size)
+{
+    const size_t before = completed_.size();
+    const char* c = data;
+    const char* const last = data + size;
+    // Appends the bytes up to end to the token being read
+    auto append = [&](const char* end) {
+        const size_t length = static_cast<size_t>(end - c);
+        if (token_.size() + length > maxToken_)
+            throw std::length_error("Value longer than " + std::to_string(maxToken_) + " bytes");
+        token_.append(c, end);
+        offset_ += length;
+        c = end;
+    };
+
+    try {
+        while (c != last) {
+            switch (lexer_) {
+            case Lexer::String: {
+                const char* end = c;
+                while (end != last && *end != '"' && *end != '\\')
+                    ++end;
+                if (end != last)
+                    ++end;
+                append(end);
+                if (token_.back() == '\\') {
+                    lexer_ = Lexer::Escape;
+                } else if (token_.size() > 1 && token_.back() == '"') {
+                    lexer_ = Lexer::Between;
+                    string();
+                }
+                break;
+            }
+            case Lexer::Escape:
+                append(c + 1);
+                lexer_ = Lexer::String;
+                break;
+            case Lexer::Scalar: {
+                const char* end = c;
+                while (end != last && !delimiter(*end))
+                    ++end;
+                append(end);
+                // The delimiter is read in turn
+                if (c != last) {
+                    lexer_ = Lexer::Between;
+                    scalar();
+                }
+                break;
+            }
+            case Lexer::Between:
+                switch (*c) {
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\r':
+                    ++c;
+                    ++offset_;
+                    break;
+                case '"':
+                    if (expect_ != Expect::Value && expect_ != Expect::ValueOrClose && expect_ != Expect::Key &&
+                        expect_ != Expect::KeyOrClose)
+                        fail("Unexpected string");
+                    token_.clear();
+                    lexer_ = Lexer::String;
+                    append(c + 1);
+                    break;
+                case '{':
+                case '}':
+                case '[':
+                case ']':
+                case ':':
+                case ',':
+                    structural(*c);
+                    ++c;
+                    ++offset_;
+                    break;
+                default:
+                    if (expect_ != Expect::Value && expect_ != Expect::ValueOrClose)
+                        fail(std::string("Unexpected '") + *c + "'");
+                    token_.clear();
+                    lexer_ = Lexer::Scalar;
+                    break;
+                }
+                break;
+            }
+        }
+    } catch (...) {
+        reset();
+        throw;
+    }
+    return completed_.size() - before;
+}
+
+std::unique_ptr<Property> JSONPushParser::next()
+{
+    if (completed_.empty())
+        return nullptr;
+    std::unique_ptr<Property> prop = std::move(completed_.front());
+    completed_.pop_front();
+    return prop;
+}
+
+bool JSONPushParser::pending() const
+{
+    return !frames_.empty() || lexer_ != Lexer::Between;
+}
+
+void JSONPushParser::reset()
+{
+    lexer_ = Lexer::Between;
+    expect_ = Expect::Value;
+    token_.clear();
+    key_.clear();
+    frames_.clear();
+}
+
+void JSONPushParser::structural(char c)
+{
+    const bool inObject = !frames_.empty() && frames_.back().object;
+    const bool inArray = !frames_.empty() && !frames_.back().object;
+    switch (c) {
+    case '{':
+        if (expect_ != Expect::Value && expect_ != Expect::ValueOrClose)
+            fail("Unexpected '{'");
+        beginObject();
+        break;
+    case '}':
+        if (!inObject || (expect_ != Expect::KeyOrClose && expect_ != Expect::CommaOrClose))
+            fail("Unexpected '}'");
+        endObject();
+        break;
+    case '[':
+        if (expect_ != Expect::Value)
+            fail("Unexpected '['");
+        beginArray();
+        break;
+    case ']':
+        if (!inArray || (expect_ != Expect::ValueOrClose && expect_ != Expect::CommaOrClose))
+            fail("Unexpected ']'");
+        endArray();
+        break;
+    case ':':
+        if (expect_ != Expect::Colon)
+            fail("Unexpected ':'");
+        expect_ = Expect::Value;
+        break;
+    case ',':
+        if (expect_ != Expect::CommaOrClose)
+            fail("Unexpected ','");
+        expect_ = inObject ? Expect::Key : Expect::Value;
+        break;
+    }
+}
+
+void JSONPushParser::string()
+{
+    std::string decoded;
+    bool plain = true;
+    for (char c : token_)
+        plain = plain && static_cast<unsigned char>(c) >= 0x20 && static_cast<unsigned char>(c) < 0x80 && c != '\\';
+    if (plain) {
+        decoded.assign(token_, 1, token_.size() - 2);
+    } else {
+        try {
+            // Unescaped and validated as UTF-8 by nlohmann
+            decoded = json::parse(token_).get<std::string>();
+        } catch (const json::exception&) {
+            fail("Invalid string " + token_);
+        }
+    }
+
+    if (expect_ == Expect::Key || expect_ == Expect::KeyOrClose) {
+        key_ = std::move(decoded);
+        expect_ = Expect::Colon;
+    } else {
+        value(std::move(decoded));
+    }
+}
+
+void JSONPushParser::scalar()
+{
+    json parsed;
+    try {
+        if (!json_scanner::scalar(token_.data(), token_.data() + token_.size(), parsed))
+            fail("Invalid value " + token_);
+    } catch (const json::exception&) {
+        // Long numbers are converted by nlohmann, which rejects overflows
+        fail("Invalid value " + token_);
+    }
+    value(std::move(parsed));
+}
+
+void JSONPushParser::value(json&& value)
+{
+    if (frames_.empty() || !frames_.back().object)
+        fail("Expected an object");
+    // As nlohmann, the last of duplicate keys wins
+    frames_.back().members[key_] = std::move(value);
+    expect_ = Expect::CommaOrClose;
+}
+
+void JSONPushParser::beginObject()
+{
+    if (!frames_.empty() && frames_.back().object)
+        fail("Unexpected object as value of " + key_);
+    frames_.emplace_back(true);
+    expect_ = Expect::KeyOrClose;
+}
+
+void JSONPushParser::endObject()
+{
+    Frame frame = std::move(frames_.back());
+    frames_.pop_back();
+
+    std::unique_ptr<Property> prop;
+    if (frame.hasChildren) {
+        // The profile is recognised from the key of the id, as JSONSerialiser does
+        const bool compact = frame.members.count("i") != 0;
+        const std::string& id = text(frame.members, compact ? "i" : "id");
+        if (id != GroupProperty::identifier)
+            fail("Children in a property of type " + id);
+        prop = std::make_unique<OwnedGroupProperty>(text(frame.members, compact ? "n" : "name"),
+                                                    text(frame.members, compact ? "d" : "display"),
+                                                    std::move(frame.children));
+    } else {
+        try {
+            prop = serialiser_.deserialiseDocument(frame.members, JSONSerialiser::Materialisation::Eager);
+        } catch (const json::exception& e) {
+            // Members missing or of another type than the property expects
+            fail(std::string("Invalid property: ") + e.what());
+        }
+    }
+
+    if (frames_.empty()) {
+        completed_.push_back(std::move(prop));
+        expect_ = Expect::Value;
+    } else {
+        frames_.back().children.push_back(std::move(prop));
+        expect_ = Expect::CommaOrClose;
+    }
+}
+
+void JSONPushParser::beginArray()
+{
+    if (frames_.empty() || !frames_.back().object || (key_ != "children" && key_ != "c") ||
+        frames_.back().hasChildren)
+        fail("Unexpected array");
+    frames_.back().hasChildren = true;
+    frames_.emplace_back(false);
+    expect_ = Expect::ValueOrClose;
+}
+
+void JSONPushParser::endArray()
+{
+    std::vector<std::unique_ptr<Property>> children = std::move(frames_.back().children);
+    frames_.pop_back();
+    frames_.back().children = std::move(children);
+    expect_ = Expect::CommaOrClose;
+}
+
+void JSONPushParser::fail(const std::string& what) const
+{
+    throw std::invalid_argument(what + " at byte " + std::to_string(offset_));
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "json_serialiser.h"
+#include "properties_export.h"
+
+#include <deque>
+#include <vector>
+
+namespace property
+{
+
+/// Deserialises properties from JSON text received in chunks of any size, e.g. from a pipe or a socket, without
+/// holding the text of a whole document. Documents follow each other, separated by whitespace or not (newline
+/// delimited JSON included). Every property is built as soon as its object is closed, and its text dropped: the
+/// parser keeps the text of one value split across two chunks, and the properties and members of the objects still
+/// open, which grow with the document being parsed.
+///
+/// Documents are deserialised as JSONSerialiser::deserialise does, in any profile, but never lazily.
+class PROPERTIES_EXPORT JSONPushParser
+{
+public:
+    explicit JSONPushParser(const JSONSerialiser& serialiser = JSONSerialiser::shared(), size_t maxToken = 1 << 26);
+    ~JSONPushParser();
+
+    /// Parses the next chunk, and returns the number of documents completed by it. Invalid text throws
+    /// std::invalid_argument, strings longer than maxToken std::length_error; the document being parsed is then
+    /// dropped, and parsing resumes at the next chunk as if at the start of a document.
+    size_t feed(const char* data, size_t size);
+    size_t feed(const std::string& chunk) { return feed(chunk.data(), chunk.size()); }
+
+    /// Next completed document, nullptr if there is none yet
+    std::unique_ptr<Property> next();
+
+    /// Whether a document has been started and not completed yet, i.e. whether the input would end too early here
+    bool pending() const;
+    /// Drops the document being parsed, if any
+    void reset();
+
+private:
+    enum class Lexer : unsigned char { Between, String, Escape, Scalar };
+    enum class Expect : unsigned char { Value, ValueOrClose, Key, KeyOrClose, Colon, CommaOrClose };
+
+    /// Object or array being parsed. Arrays only appear as the children of groups.
+    struct Frame;
+
+    void structural(char c);
+    void string();
+    void scalar();
+    void value(nlohmann::json&& value);
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    [[noreturn]] void fail(const std::string& what) const;
+
+private:
+    const JSONSerialiser& serialiser_;
+    const size_t maxToken_;
+    Lexer lexer_{Lexer::Between};
+    Expect expect_{Expect::Value};
+    /// Text of the string or scalar being read, quotes included
+    std::string token_;
+    /// Key of the value being read
+    std::string key_;
+    std::vector<Frame> frames_;
+    std::deque<std::unique_ptr<Property>> completed_;
+    /// Position in the whole input, for errors
+    size_t offset_{0};
+};
+}
@@ -0,0 +1,477 @@
+#include "json_scanner.h"
+
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if !defined(PROPERTIES_NO_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PROPERTIES_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace property
+{
+namespace json_scanner
+{
+
+namespace
+{
+
+/// Characters of one 64-byte block, one bit per byte
+struct Masks {
+    uint64_t quote;
+    uint64_t backslash;
+    /// Brackets, braces, colons and commas
+    uint64_t structural;
+    uint64_t whitespace;
+    /// Control characters and non-ASCII bytes, which are only copied as they are once checked by nlohmann
+    uint64_t unusual;
+};
+
+Masks classifyPortable(const char* block)
+{
+    enum : unsigned char { Quote = 1, Backslash = 2, Structural = 4, Whitespace = 8, Unusual = 16 };
+    struct Classes {
+        Classes()
+        {
+            for (unsigned c = 0; c < 256; ++c)
+                of[c] = c < 0x20 || c >= 0x80 ? Unusual : 0;
+            of['"'] = Quote;
+            of['\\'] = Backslash;
+            for (unsigned char c : {'{', '}', '[', ']', ':', ','})
+                of[c] = Structural;
+            for (unsigned char c : {' ', '\t', '\n', '\r'})
+                of[c] |= Whitespace;
+        }
+        unsigned char of[256];
+    };
+    static const Classes classes;
+
+    Masks masks{0, 0, 0, 0, 0};
+    for (unsigned i = 0; i < 64; ++i) {
+        const uint64_t c = classes.of[static_cast<unsigned char>(block[i])];
+        masks.quote |= (c & Quote) << i;
+        masks.backslash |= (c >> 1 & 1) << i;
+        masks.structural |= (c >> 2 & 1) << i;
+        masks.whitespace |= (c >> 3 & 1) << i;
+        masks.unusual |= (c >> 4 & 1) << i;
+    }
+    return masks;
+}
+
+#ifdef PROPERTIES_X86_SIMD
+
+__attribute__((target("avx2"))) inline uint64_t bits(__m256i lo, __m256i hi)
+{
+    return static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+           static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32;
+}
+
+__attribute__((target("avx2"))) inline uint64_t equal(__m256i lo, __m256i hi, char c)
+{
+    const __m256i pattern = _mm256_set1_epi8(c);
+    return bits(_mm256_cmpeq_epi8(lo, pattern), _mm256_cmpeq_epi8(hi, pattern));
+}
+
+__attribute__((target("avx2"))) Masks classifyAVX2(const char* block)
+{
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    // Setting bit 5 maps '[' to '{' and ']' to '}', and no other character to either
+    const __m256i bit5 = _mm256_set1_epi8(0x20);
+    const __m256i foldedLo = _mm256_or_si256(lo, bit5);
+    const __m256i foldedHi = _mm256_or_si256(hi, bit5);
+    // Signed comparison: below the space, or from 0x80 on
+    const __m256i space = _mm256_set1_epi8(0x20);
+
+    Masks masks;
+    masks.quote = equal(lo, hi, '"');
+    masks.backslash = equal(lo, hi, '\\');
+    masks.structural = equal(foldedLo, foldedHi, '{') | equal(foldedLo, foldedHi, '}') | equal(lo, hi, ':') |
+                       equal(lo, hi, ',');
+    masks.whitespace = equal(lo, hi, ' ') | equal(lo, hi, '\t') | equal(lo, hi, '\n') | equal(lo, hi, '\r');
+    masks.unusual = bits(_mm256_cmpgt_epi8(space, lo), _mm256_cmpgt_epi8(space, hi));
+    return masks;
+}
+
+__attribute__((target("sse4.2"))) Masks classifySSE42(const char* block)
+{
+    constexpr int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+    const __m128i structural = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i whitespace = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    Masks masks{0, 0, 0, 0, 0};
+    for (unsigned i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+        const unsigned shift = 16 * i;
+        // Lengths are explicit, so that NUL bytes in the text are classified like any other
+        masks.structural |= static_cast<uint64_t>(_mm_cvtsi128_si32(_mm_cmpestrm(structural, 6, v, 16, mode)) & 0xffff)
+                            << shift;
+        masks.whitespace |= static_cast<uint64_t>(_mm_cvtsi128_si32(_mm_cmpestrm(whitespace, 4, v, 16, mode)) & 0xffff)
+                            << shift;
+        masks.quote |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote))) << shift;
+        masks.backslash |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash))) << shift;
+        masks.unusual |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(space, v))) << shift;
+    }
+    return masks;
+}
+
+#endif
+
+/// Characters escaped by a backslash. Backslashes are rare enough to be walked one by one; carry tells whether the
+/// first character of the block is escaped by the last one of the previous block.
+uint64_t escapedBy(uint64_t backslash, bool& carry)
+{
+    uint64_t escaped = 0;
+    if (carry) {
+        escaped = 1;
+        backslash &= ~uint64_t(1);
+        carry = false;
+    }
+    while (backslash) {
+        const unsigned at = __builtin_ctzll(backslash);
+        if (at == 63) {
+            carry = true;
+            break;
+        }
+        escaped |= uint64_t(1) << (at + 1);
+        // The escaped character is not an escape itself, even if it is a backslash
+        backslash &= ~(uint64_t(3) << at);
+    }
+    return escaped;
+}
+
+/// Bit i is set if an odd number of bits are set up to i included
+uint64_t prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+bool digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/// Checks the grammar of a number, and converts it as nlohmann does
+bool number(const char* begin, const char* end, json& out)
+{
+    const char* c = begin;
+    const bool negative = *c == '-';
+    if (negative)
+        ++c;
+    const char* digits = c;
+    if (c != end && *c == '0') {
+        ++c;
+    } else {
+        if (c == end || !digit(*c))
+            return false;
+        while (c != end && digit(*c))
+            ++c;
+    }
+    const char* integral = c;
+    if (c != end && *c == '.') {
+        if (++c == end || !digit(*c))
+            return false;
+        while (c != end && digit(*c))
+            ++c;
+    }
+    if (c != end && (*c == 'e' || *c == 'E')) {
+        if (++c != end && (*c == '+' || *c == '-'))
+            ++c;
+        if (c == end || !digit(*c))
+            return false;
+        while (c != end && digit(*c))
+            ++c;
+    }
+    if (c != end)
+        return false;
+
+    if (integral == end && end - digits <= 18) {
+        uint64_t magnitude = 0;
+        for (c = digits; c != end; ++c)
+            magnitude = magnitude * 10 + static_cast<uint64_t>(*c - '0');
+        if (negative)
+            out = -static_cast<json::number_integer_t>(magnitude);
+        else
+            out = static_cast<json::number_unsigned_t>(magnitude);
+        return true;
+    }
+    // Longer integers may still fit in 64 bits, nlohmann decides. strtod needs a terminated text, and expects
+    // the decimal point of the current locale.
+    char buffer[64];
+    const size_t length = static_cast<size_t>(end - begin);
+    if (integral == end || length >= sizeof(buffer) || *std::localeconv()->decimal_point != '.') {
+        out = json::parse(begin, end);
+        return true;
+    }
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    const double value = std::strtod(buffer, nullptr);
+    // nlohmann rejects overflows
+    if (!std::isfinite(value))
+        return false;
+    out = value;
+    return true;
+}
+
+/// Second pass: builds the document from the structural index
+class Builder
+{
+public:
+    Builder(const char* data, size_t size, const StructuralIndex& index)
+        : data_{data}, size_{size}, positions_{index.positions}, plain_{index.plain}
+    {
+    }
+
+    bool build(json& root) { return value(root, 0) && next_ == positions_.size(); }
+
+private:
+    /// Deeper documents are left to nlohmann, whose parser does not recurse
+    static constexpr unsigned maxDepth = 512;
+
+    char peek() const { return next_ < positions_.size() ? data_[positions_[next_]] : '\0'; }
+
+    bool value(json& out, unsigned depth)
+    {
+        if (depth > maxDepth)
+            return false;
+        switch (peek()) {
+        case '{': {
+            ++next_;
+            out = json::object();
+            json::object_t& object = *out.get_ptr<json::object_t*>();
+            if (peek() == '}') {
+                ++next_;
+                return true;
+            }
+            for (;;) {
+                std::string key;
+                if (!string(key) || peek() != ':')
+                    return false;
+                ++next_;
+                // As nlohmann, the last of duplicate keys wins
+                if (!value(object[std::move(key)], depth + 1))
+                    return false;
+                const char separator = peek();
+                ++next_;
+                if (separator == '}')
+                    return true;
+                if (separator != ',')
+                    return false;
+            }
+        }
+        case '[': {
+            ++next_;
+            out = json::array();
+            json::array_t& array = *out.get_ptr<json::array_t*>();
+            if (peek() == ']') {
+                ++next_;
+                return true;
+            }
+            for (;;) {
+                array.emplace_back();
+                if (!value(array.back(), depth + 1))
+                    return false;
+                const char separator = peek();
+                ++next_;
+                if (separator == ']')
+                    return true;
+                if (separator != ',')
+                    return false;
+            }
+        }
+        case '"': {
+            std::string text;
+            if (!string(text))
+                return false;
+            out = std::move(text);
+            return true;
+        }
+        case '\0':
+        case '}':
+        case ']':
+        case ':':
+        case ',':
+            return false;
+        default:
+            return scalar(out);
+        }
+    }
+
+    bool string(std::string& out)
+    {
+        if (peek() != '"' || next_ + 1 >= positions_.size())
+            return false;
+        const char* begin = data_ + positions_[next_] + 1;
+        const char* end = data_ + positions_[next_ + 1];
+        next_ += 2;
+        if (!plain_) {
+            for (const char* c = begin; c != end; ++c) {
+                const unsigned char byte = static_cast<unsigned char>(*c);
+                if (byte < 0x20 || byte >= 0x80 || byte == '\\') {
+                    // Unescaped and validated as UTF-8 by nlohmann, quotes included
+                    out = json::parse(begin - 1, end + 1).get<std::string>();
+                    return true;
+                }
+            }
+        }
+        out.assign(begin, end);
+        return true;
+    }
+
+    static bool delimiter(char c)
+    {
+        switch (c) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case '"':
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool scalar(json& out)
+    {
+        const char* begin = data_ + positions_[next_++];
+        const char* end = begin;
+        const char* last = data_ + size_;
+        while (end != last && !delimiter(*end))
+            ++end;
+        return json_scanner::scalar(begin, end, out);
+    }
+
+private:
+    const char* const data_;
+    const size_t size_;
+    const std::vector<uint32_t>& positions_;
+    const bool plain_;
+    size_t next_{0};
+};
+}
+
+Isa detect()
+{
+#ifdef PROPERTIES_X86_SIMD
+    static const Isa best = __builtin_cpu_supports("avx2")     ? Isa::AVX2
+                            : __builtin_cpu_supports("sse4.2") ? Isa::SSE42
+                                                               : Isa::Portable;
+    return best;
+#else
+    return Isa::Portable;
+#endif
+}
+
+bool scalar(const char* begin, const char* end, json& out)
+{
+    const size_t length = static_cast<size_t>(end - begin);
+    if (length == 4 && std::memcmp(begin, "true", 4) == 0) {
+        out = true;
+        return true;
+    }
+    if (length == 5 && std::memcmp(begin, "false", 5) == 0) {
+        out = false;
+        return true;
+    }
+    if (length == 4 && std::memcmp(begin, "null", 4) == 0) {
+        out = nullptr;
+        return true;
+    }
+    return begin != end && number(begin, end, out);
+}
+
+bool supported(Isa isa)
+{
+    return static_cast<int>(isa) <= static_cast<int>(detect());
+}
+
+bool index(const char* data, size_t size, StructuralIndex& index, Isa isa)
+{
+    if (!supported(isa))
+        throw std::invalid_argument("Instruction set not supported by this processor");
+    index.positions.clear();
+    index.plain = true;
+    if (size > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    Masks (*classify)(const char*) = classifyPortable;
+#ifdef PROPERTIES_X86_SIMD
+    if (isa == Isa::AVX2)
+        classify = classifyAVX2;
+    else if (isa == Isa::SSE42)
+        classify = classifySSE42;
+#endif
+
+    // Typical documents have a structural character every few bytes
+    index.positions.reserve(size / 4);
+    bool escapedCarry = false;
+    uint64_t stringCarry = 0;
+    uint64_t scalarCarry = 0;
+    uint64_t unusual = 0;
+    char tail[64];
+    for (size_t offset = 0; offset < size; offset += 64) {
+        const char* block = data + offset;
+        if (size - offset < 64) {
+            // Whitespace changes nothing past the end
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, size - offset);
+            block = tail;
+        }
+        const Masks masks = classify(block);
+        const uint64_t quotes = masks.quote & ~escapedBy(masks.backslash, escapedCarry);
+        // From the opening quote of every string to the character before its closing quote
+        const uint64_t inString = prefixXor(quotes) ^ stringCarry;
+        stringCarry = 0 - (inString >> 63);
+        const uint64_t scalars = ~(masks.structural | masks.whitespace | masks.quote | inString);
+        const uint64_t scalarStarts = scalars & ~(scalars << 1 | scalarCarry);
+        scalarCarry = scalars >> 63;
+        unusual |= (masks.unusual | masks.backslash) & inString;
+
+        uint64_t found = (masks.structural & ~inString) | quotes | scalarStarts;
+        size_t at = index.positions.size();
+        index.positions.resize(at + static_cast<size_t>(__builtin_popcountll(found)));
+        for (; found; found &= found - 1)
+            index.positions[at++] = static_cast<uint32_t>(offset + __builtin_ctzll(found));
+    }
+    index.plain = unusual == 0;
+    return stringCarry == 0;
+}
+
+json parse(const char* data, size_t size, Isa isa)
+{
+    StructuralIndex structural;
+    if (index(data, size, structural, isa)) {
+        json root;
+        try {
+            if (Builder(data, size, structural).build(root))
+                return root;
+        } catch (const json::exception&) {
+            // Reported below, at its position in the whole text
+        }
+    }
+    return json::parse(data, data + size);
+}
+}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "properties_export.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace property
+{
+
+/// Parses JSON text in two passes, as simdjson does: the first locates the structural characters and the strings of
+/// 64 bytes at once with vector instructions, the second builds the document from their positions only, without
+/// looking at the bytes between them again.
+namespace json_scanner
+{
+
+/// Instruction sets of the first pass, chosen at runtime
+enum class Isa { Portable, SSE42, AVX2 };
+
+/// Widest instruction set supported by the processor (and the build, see PROPERTIES_SIMD)
+PROPERTIES_EXPORT Isa detect();
+PROPERTIES_EXPORT bool supported(Isa isa);
+
+struct StructuralIndex {
+    /// Offsets of the brackets, braces, colons and commas outside strings, of the quotes opening and closing every
+    /// string, and of the first character of every other scalar, in increasing order
+    std::vector<uint32_t> positions;
+    /// Whether no string contains an escape sequence, a control character or a non-ASCII byte, i.e. all of them can
+    /// be copied as they are
+    bool plain{true};
+};
+
+/// First pass, replacing the content of index. Returns false for a text it cannot index: an unterminated string,
+/// or more than 4 GiB.
+PROPERTIES_EXPORT bool index(const char* data, size_t size, StructuralIndex& index, Isa isa = detect());
+
+/// Converts the text of a literal or a number as nlohmann does, returns false if it is neither
+PROPERTIES_EXPORT bool scalar(const char* begin, const char* end, nlohmann::json& out);
+
+/// Parses a document as nlohmann::json::parse does. Texts the scanner does not handle itself (invalid ones, or
+/// e.g. nested deeper than its limit) are handed to nlohmann::json::parse, which reports the errors.
+PROPERTIES_EXPORT nlohmann::json parse(const char* data, size_t size, Isa isa = detect());
+}
+}
@@ -1,33 +1,205 @@
 #include "json_serialiser.h"
 
+#include "interner.h"
+#include "json_scanner.h"
+#include "json_writer.h"
+#include "owned_group_property.h"
+
+#include "../basic_property.h"
+#include "../numeric_property.h"
+#include "../property_table.h"
+
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
 namespace property
 {
 
+namespace
+{
+
+/// Keys of the properties in one profile
+struct JSONKeys {
+    const char* id;
+    const char* name;
+    const char* display;
+    const char* value;
+    const char* min;
+    const char* max;
+    const char* children;
+    /// Of tables
+    const char* columns;
+    const char* schema;
+};
+
+const JSONKeys verboseKeys{"id", "name", "display", "value", "min", "max", "children", "columns", "schema"};
+const JSONKeys compactKeys{"i", "n", "d", "v", "l", "h", "c", "a", "s"};
+
+const JSONKeys& keysOf(JSONSerialiser::Profile profile)
+{
+    return profile == JSONSerialiser::Profile::Verbose ? verboseKeys : compactKeys;
+}
+}
+
 struct JSONNode : public Node {
-    JSONNode(json& node) : node_{node} {}
+    using Profile = JSONSerialiser::Profile;
+
+    JSONNode(json& node,
+             Profile profile,
+             bool lazy = false,
+             Interner* interner = nullptr,
+             Interner* descriptors = nullptr)
+        : node_{node}, profile_{profile}, keys_{keysOf(profile)}, lazy_{lazy}, interner_{interner},
+          descriptors_{descriptors}
+    {
+    }
+    /// Child node, in the same profile as its parent
+    JSONNode(json& node, const JSONNode& parent)
+        : node_{node}, profile_{parent.profile_}, keys_{parent.keys_}, lazy_{parent.lazy_},
+          interner_{parent.interner_}, descriptors_{parent.descriptors_}
+    {
+    }
+
+    /// Profile of a document, recognised from the keys of its root
+    static Profile detect(const json& root)
+    {
+        return root.is_object() && root.count(compactKeys.id) ? Profile::Compact : Profile::Verbose;
+    }
+
+    const std::string& id() const override { return node_.at(keys_.id).get_ref<const std::string&>(); }
+    const std::string& name() const override
+    {
+        if (name_)
+            return *name_;
+        return string(keys_.name);
+    }
+    const std::string& displayName() const override { return string(keys_.display); }
 
-    std::string id() override { return node_["id"]; }
+    std::unique_ptr<Node> child(const std::string& name, size_t position) const override
+    {
+        auto children = node_.find(keys_.children);
+        if (children == node_.end())
+            return nullptr;
+        for (json& child : *children) {
+            auto it = child.find(keys_.name);
+            if (it != child.end() && *it == name)
+                return std::make_unique<JSONNode>(child, *this);
+        }
+        if (position < children->size() && !(*children)[position].count(keys_.name)) {
+            auto child = std::make_unique<JSONNode>((*children)[position], *this);
+            child->name_ = &name;
+            return std::move(child);
+        }
+        return nullptr;
+    }
+
+    /// Read-only lookup, nullptr if the key is missing
+    const json* field(const char* key) const
+    {
+        auto it = node_.find(key);
+        return it != node_.end() ? &*it : nullptr;
+    }
+    template <class T>
+    T value(const char* key, const T& fallback) const
+    {
+        const json* found = field(key);
+        return found ? found->get<T>() : fallback;
+    }
+    /// Optional string, empty if the key is missing
+    const std::string& string(const char* key) const
+    {
+        static const std::string none;
+        const json* found = field(key);
+        return found ? found->get_ref<const std::string&>() : none;
+    }
+    /// Descriptor built from args, shared with the other nodes of the document describing the same
+    template <class D, class... Args>
+    std::shared_ptr<const D> describe(Args&&... args) const
+    {
+        auto descriptor = std::make_shared<const D>(std::forward<Args>(args)...);
+        return descriptors_ ? descriptors_->intern(std::move(descriptor)) : descriptor;
+    }
 
     json& node_;
+    const Profile profile_;
+    const JSONKeys& keys_;
+    /// Groups below this node defer the construction of their children
+    const bool lazy_;
+    /// Shares the identical children of groups below this node, if set
+    Interner* const interner_;
+    /// Shares the descriptors of the leaves below this node, if set
+    Interner* const descriptors_;
+    /// Name of a child read by position, its own being omitted
+    const std::string* name_{nullptr};
+};
+
+/// Writes JSON text straight into a string, without building a document first
+struct JSONOutput : public Output {
+    using Profile = JSONSerialiser::Profile;
+
+    JSONOutput(std::string& out, Profile profile, bool memoise = false)
+        : out_{out}, profile_{profile}, keys_{keysOf(profile)}, memoise_{memoise}
+    {
+    }
+    /// Child output, in the same profile as its parent
+    JSONOutput(const JSONOutput& parent, bool anonymous)
+        : out_{parent.out_},
+          profile_{parent.profile_},
+          keys_{parent.keys_},
+          anonymous_{anonymous},
+          memoise_{parent.memoise_}
+    {
+    }
+
+    bool compact() const { return profile_ != Profile::Verbose; }
+
+    template <class T>
+    void member(const char* key, const T& value)
+    {
+        json_writer::key(out_, first_, key);
+        json_writer::append(out_, value);
+    }
+    /// Starts a member whose value is then written by the caller
+    void member(const char* key) { json_writer::key(out_, first_, key); }
+
+    std::string& out_;
+    const Profile profile_;
+    const JSONKeys& keys_;
+    /// Whether to omit the name, the property being identified by its position
+    const bool anonymous_{false};
+    /// Whether groups keep their output, see JSONSerialiser::Memoisation
+    const bool memoise_{false};
+    bool first_{true};
 };
 
 class JSONPropertySerialiser : public PropertySerialiser
 {
-private:
-    void serialise(Node& raw, const Property& prop) override
+protected:
+    /// Members are written sorted by key as nlohmann::json used to, the maximum ("h") preceding the id ("i") in the
+    /// compact profiles
+    void serialise(Output& raw, const Property& prop) const override
     {
-        JSONNode& node = raw.cast<JSONNode>();
-        node.node_["id"] = prop.id();
-        node.node_["name"] = prop.name();
-        node.node_["display"] = prop.displayName();
-
-        serialiseInternals(node, prop);
+        JSONOutput& out = raw.cast<JSONOutput>();
+        out.out_ += '{';
+        serialiseChildren(out, prop);
+        if (!out.compact() || prop.displayName() != prop.name())
+            out.member(out.keys_.display, prop.displayName());
+        if (out.compact())
+            serialiseMax(out, prop);
+        out.member(out.keys_.id, prop.id());
+        if (!out.compact())
+            serialiseMax(out, prop);
+        serialiseMin(out, prop);
+        if (!out.anonymous_)
+            out.member(out.keys_.name, prop.name());
+        serialiseValue(out, prop);
+        out.out_ += '}';
     }
 
-    virtual void serialiseInternals(JSONNode& node, const Property& prop) = 0;
+    virtual void serialiseChildren(JSONOutput& /*out*/, const Property& /*prop*/) const {}
+    virtual void serialiseMax(JSONOutput& /*out*/, const Property& /*prop*/) const {}
+    virtual void serialiseMin(JSONOutput& /*out*/, const Property& /*prop*/) const {}
+    virtual void serialiseValue(JSONOutput& /*out*/, const Property& /*prop*/) const {}
 };
 
 template <class T>
@@ -36,16 +208,17 @@ class JSONBasicSerialiser : public JSONPropertySerialiser
 public:
     using value_type = T;
 
-    std::unique_ptr<Property> deserialise(Node& raw) override
+    std::unique_ptr<Property> deserialise(const Node& raw) const override
     {
-        JSONNode& node = raw.cast<JSONNode>();
-        const typename T::value_type value = node.node_["value"];
-        return std::make_unique<T>(node.node_["name"], value, node.node_["display"]);
+        const JSONNode& node = raw.cast<JSONNode>();
+        const json& value = node.node_.at(node.keys_.value);
+        return std::make_unique<T>(node.describe<Descriptor>(node.name(), node.displayName()),
+                                   value.get_ref<const typename T::value_type&>());
     }
 
-    void serialiseInternals(JSONNode& node, const Property& prop) override
+    void serialiseValue(JSONOutput& out, const Property& prop) const override
     {
-        node.node_["value"] = prop.cast<value_type>().value();
+        out.member(out.keys_.value, prop.cast<value_type>().value());
     }
 };
 
@@ -55,53 +228,91 @@ class JSONNumericSerialiser : public JSONPropertySerialiser
 public:
     using value_type = T;
 
-    std::unique_ptr<Property> deserialise(Node& raw) override
+    std::unique_ptr<Property> deserialise(const Node& raw) const override
     {
-        JSONNode& node = raw.cast<JSONNode>();
-        const typename T::value_type value = node.node_["value"];
-        const typename T::value_type min = node.node_["min"];
-        const typename T::value_type max = node.node_["max"];
-        return std::make_unique<T>(node.node_["name"], value, min, max, node.node_["display"]);
+        const JSONNode& node = raw.cast<JSONNode>();
+        using V = typename T::value_type;
+        const V value = node.node_.at(node.keys_.value).get<V>();
+        const V min = node.value<V>(node.keys_.min, V(-T::max_value));
+        const V max = node.value<V>(node.keys_.max, V(T::max_value));
+        return std::make_unique<T>(
+            node.describe<typename T::Descriptor>(node.name(), min, max, node.displayName()), value);
     }
 
-    void serialiseInternals(JSONNode& node, const Property& prop) override
+    void serialiseMax(JSONOutput& out, const Property& prop) const override
     {
         const T& numeric = prop.cast<value_type>();
-        node.node_["value"] = numeric.value();
-        if (numeric.min() != -value_type::max_value)
-            node.node_["min"] = numeric.min();
         if (numeric.max() != value_type::max_value)
-            node.node_["max"] = numeric.max();
+            out.member(out.keys_.max, numeric.max());
+    }
+    void serialiseMin(JSONOutput& out, const Property& prop) const override
+    {
+        const T& numeric = prop.cast<value_type>();
+        if (numeric.min() != -value_type::max_value)
+            out.member(out.keys_.min, numeric.min());
+    }
+    void serialiseValue(JSONOutput& out, const Property& prop) const override
+    {
+        out.member(out.keys_.value, prop.cast<value_type>().value());
     }
 };
 
-class JSONGroupProperty : public GroupProperty
+/// Group keeping its children as JSON until they are first reached by find, get or an iterator
+class JSONLazyGroupProperty : public GroupProperty, private GroupPropertyIterator::Materialiser
 {
 public:
-    JSONGroupProperty(std::function<std::unique_ptr<Property>(Node& node)> deserialise, json& node)
-        : GroupProperty(node["name"], node["display"])
+    JSONLazyGroupProperty(std::function<std::unique_ptr<Property>(const Node& node)> deserialise,
+                          const JSONNode& node)
+        : GroupProperty(node.name(), node.displayName()),
+          deserialise_{deserialise},
+          profile_{node.profile_},
+          pending_(std::move(node.node_.at(node.keys_.children))),
+          childrenPointers_(pending_.size(), nullptr),
+          children_(pending_.size())
     {
-        json& children = node["children"];
-        const size_t total = children.size();
-        childrenPointers_.resize(total);
-        children_.resize(total);
-        for (size_t i = 0; i < total; ++i) {
-            JSONNode child(children[i]);
-            children_[i] = deserialise(child);
-            childrenPointers_[i] = children_[i].get();
-        }
     }
 
-    GroupPropertyIterator begin() const override { return GroupPropertyIterator{childrenPointers_.data(), 0, size()}; }
+    GroupPropertyIterator begin() const override
+    {
+        return GroupPropertyIterator{childrenPointers_.data(), 0, size(), this};
+    }
+    GroupPropertyIterator find(const std::string& name) const override
+    {
+        for (size_t i = 0; i < size(); ++i) {
+            if (childrenPointers_[i] ? childrenPointers_[i]->name() == name : pendingName(i) == name)
+                return GroupPropertyIterator{childrenPointers_.data(), i, size(), this};
+        }
+        return end();
+    }
     GroupPropertyIterator end() const override
     {
-        return GroupPropertyIterator{childrenPointers_.data(), size(), size()};
+        return GroupPropertyIterator{childrenPointers_.data(), size(), size(), this};
     }
     size_t size() const override { return children_.size(); }
 
 private:
-    std::vector<const Property*> childrenPointers_;
-    std::vector<std::unique_ptr<Property>> children_;
+    const Property* materialise(size_t pos) const override
+    {
+        // Nested groups move their own children out of the pending node, which is never read again
+        JSONNode child(pending_[pos], profile_, true);
+        children_[pos] = deserialise_(child);
+        childrenPointers_[pos] = children_[pos].get();
+        return childrenPointers_[pos];
+    }
+
+    const std::string& pendingName(size_t pos) const
+    {
+        static const std::string none;
+        auto it = pending_[pos].find(keysOf(profile_).name);
+        return it != pending_[pos].end() && it->is_string() ? it->get_ref<const std::string&>() : none;
+    }
+
+private:
+    std::function<std::unique_ptr<Property>(const Node& node)> deserialise_;
+    const JSONSerialiser::Profile profile_;
+    mutable json pending_;
+    mutable std::vector<const Property*> childrenPointers_;
+    mutable std::vector<std::unique_ptr<Property>> children_;
 };
 
 class JSONGroupSerialiser : public JSONPropertySerialiser
@@ -109,34 +320,71 @@ class JSONGroupSerialiser : public JSONPropertySerialiser
 public:
     using value_type = GroupProperty;
 
-    JSONGroupSerialiser(std::function<std::unique_ptr<Property>(Node& node)> deserialiseChild,
-                        std::function<void(Node& node, const Property& prop)> serialiseChild)
+    JSONGroupSerialiser(std::function<std::unique_ptr<Property>(const Node& node)> deserialiseChild,
+                        std::function<void(Output& out, const Property& prop)> serialiseChild)
         : deserialiseChild_{deserialiseChild}, serialiseChild_{serialiseChild}
     {
     }
 
-    std::unique_ptr<Property> deserialise(Node& raw) override
+    std::unique_ptr<Property> deserialise(const Node& raw) const override
     {
-        JSONNode& node = raw.cast<JSONNode>();
-        return std::unique_ptr<JSONGroupProperty>(new JSONGroupProperty(deserialiseChild_, node.node_));
+        const JSONNode& node = raw.cast<JSONNode>();
+        if (node.lazy_)
+            return std::unique_ptr<JSONLazyGroupProperty>(new JSONLazyGroupProperty(deserialiseChild_, node));
+        json& children = node.node_.at(node.keys_.children);
+        if (node.interner_) {
+            std::vector<std::shared_ptr<const Property>> shared;
+            shared.reserve(children.size());
+            for (json& child : children)
+                shared.push_back(node.interner_->intern(deserialiseChild_(JSONNode(child, node))));
+            return std::make_unique<SharedGroupProperty>(node.name(), node.displayName(), std::move(shared));
+        }
+        std::vector<std::unique_ptr<Property>> built;
+        built.reserve(children.size());
+        for (json& child : children)
+            built.push_back(deserialiseChild_(JSONNode(child, node)));
+        return std::make_unique<OwnedGroupProperty>(node.name(), node.displayName(), std::move(built));
     }
 
-    void serialiseInternals(JSONNode& node, const Property& prop) override
+    void serialise(Output& raw, const Property& prop) const override
     {
+        JSONOutput& out = raw.cast<JSONOutput>();
+        if (!out.memoise_) {
+            JSONPropertySerialiser::serialise(raw, prop);
+            return;
+        }
+        // The output of a group depends on the profile and on whether its own name is written
+        const uint64_t key = uint64_t('J') << 8 | static_cast<uint64_t>(out.profile_) << 1 | out.anonymous_;
         const value_type& group = prop.cast<value_type>();
-        const size_t size = group.size();
-        node.node_["children"] = std::vector<json>(size);
-        auto it = group.begin();
-        for (size_t i = 0; i < size; ++i) {
-            JSONNode child(node.node_["children"][i]);
-            serialiseChild_(child, *it);
-            ++it;
+        if (const std::string* memo = group.memo(key)) {
+            out.out_ += *memo;
+            return;
         }
+        const size_t begin = out.out_.size();
+        JSONPropertySerialiser::serialise(raw, prop);
+        group.memoise(key, out.out_.substr(begin));
+    }
+
+    void serialiseChildren(JSONOutput& out, const Property& prop) const override
+    {
+        const value_type& group = prop.cast<value_type>();
+        const bool anonymous = out.profile_ == JSONOutput::Profile::Positional && group.fixedLayout();
+        out.member(out.keys_.children);
+        out.out_ += '[';
+        bool first = true;
+        for (const Property& child : group) {
+            if (!first)
+                out.out_ += ',';
+            first = false;
+            JSONOutput childOut(out, anonymous);
+            serialiseChild_(childOut, child);
+        }
+        out.out_ += ']';
     }
 
 private:
-    std::function<std::unique_ptr<Property>(Node& node)> deserialiseChild_;
-    std::function<void(Node& node, const Property& prop)> serialiseChild_;
+    std::function<std::unique_ptr<Property>(const Node& node)> deserialiseChild_;
+    std::function<void(Output& out, const Property& prop)> serialiseChild_;
 };
 
 JSONSerialiser::JSONSerialiser()
@@ -148,18 +396,336 @@ JSONSerialiser::JSONSerialiser()
 {
 }
 
-std::unique_ptr<Property> JSONSerialiser::deserialise(const std::string& jsonString) const
+std::unique_ptr<Property> JSONSerialiser::deserialise(const std::string& jsonString,
+                                                      Materialisation materialisation) const
 {
-    json root = json::parse(jsonString);
-    JSONNode node{root};
+    return deserialise(jsonString.data(), jsonString.size(), materialisation);
+}
+
+std::unique_ptr<Property> JSONSerialiser::deserialise(const char* data,
+                                                      size_t size,
+                                                      Materialisation materialisation) const
+{
+    json root = json_scanner::parse(data, size);
+    return deserialiseDocument(root, materialisation);
+}
+
+std::unique_ptr<Property> JSONSerialiser::deserialiseDocument(json& root, Materialisation materialisation) const
+{
+    // Lives as long as the instances and descriptors it shares are being looked up, they then belong to properties
+    Interner interner;
+    JSONNode node{root,
+                  JSONNode::detect(root),
+                  materialisation == Materialisation::Lazy,
+                  materialisation == Materialisation::Interned ? &interner : nullptr,
+                  &interner};
     return deserialiseNode(node);
 }
 
-std::string JSONSerialiser::serialise(const Property& prop) const
+std::unique_ptr<Property> JSONSerialiser::deserialise(const std::string& jsonString, const std::type_index& type) const
+{
+    json root = json_scanner::parse(jsonString.data(), jsonString.size());
+    Interner descriptors;
+    JSONNode node{root, JSONNode::detect(root), false, nullptr, &descriptors};
+    return deserialiseNode(node, type);
+}
+
+std::string JSONSerialiser::serialise(const Property& prop, Profile profile, Memoisation memoisation) const
+{
+    std::string out;
+    serialise(prop, out, profile, memoisation);
+    return out;
+}
+
+void JSONSerialiser::serialise(const Property& prop,
+                               std::string& out,
+                               Profile profile,
+                               Memoisation memoisation) const
+{
+    out.clear();
+    JSONOutput output{out, profile, memoisation == Memoisation::On};
+    serialiseNode(output, prop);
+}
+
+JSONSerialiser::Plan JSONSerialiser::compile(const Property& prop, Profile profile) const
+{
+    // Mirrors the order of JSONPropertySerialiser::serialise and its overrides
+    struct Compiler {
+        using Kind = Plan::Step::Kind;
+
+        /// Appends constant text, to the previous step when it is a text too
+        std::string& text()
+        {
+            if (plan_.steps_.empty() || plan_.steps_.back().kind != Kind::Text)
+                plan_.steps_.push_back({Kind::Text, false, false, nullptr, plan_.texts_.size(), 0});
+            return plan_.texts_;
+        }
+        void close() { plan_.steps_.back().size = plan_.texts_.size() - plan_.steps_.back().offset; }
+        void step(Kind kind, const Property& prop, bool anonymous = false, bool first = false)
+        {
+            if (!plan_.steps_.empty() && plan_.steps_.back().kind == Kind::Text)
+                close();
+            plan_.steps_.push_back({kind, anonymous, first, &prop, 0, 0});
+        }
+
+        void compile(const Property& prop, bool anonymous)
+        {
+            const GroupProperty* group = dynamic_cast<const GroupProperty*>(&prop);
+            Kind value = Kind::Subtree;
+            Kind max = Kind::Subtree;
+            Kind min = Kind::Subtree;
+            if (prop.id() == BooleanProperty::identifier) {
+                value = Kind::Bool;
+            } else if (prop.id() == StringProperty::identifier) {
+                value = Kind::String;
+            } else if (prop.id() == IntProperty::identifier) {
+                value = Kind::Int;
+                max = Kind::IntMax;
+                min = Kind::IntMin;
+            } else if (prop.id() == DoubleProperty::identifier) {
+                value = Kind::Double;
+                max = Kind::DoubleMax;
+                min = Kind::DoubleMin;
+            } else if (!group || prop.id() != GroupProperty::identifier) {
+                step(Kind::Subtree, prop, anonymous);
+                return;
+            }
+
+            bool first = true;
+            text() += '{';
+            if (group) {
+                json_writer::key(text(), first, keys_.children);
+                text() += '[';
+                const bool anonymousChildren = profile_ == Profile::Positional && group->fixedLayout();
+                bool firstChild = true;
+                for (const Property& child : *group) {
+                    if (!firstChild)
+                        text() += ',';
+                    firstChild = false;
+                    compile(child, anonymousChildren);
+                }
+                text() += ']';
+            }
+            if (profile_ == Profile::Verbose || prop.displayName() != prop.name()) {
+                json_writer::key(text(), first, keys_.display);
+                json_writer::append(text(), prop.displayName());
+            }
+            // Bounds steps write their own separators. A maximum written first is followed by one, so that the id
+            // which follows it must not start with another.
+            const bool compact = profile_ != Profile::Verbose;
+            if (compact && max != Kind::Subtree)
+                step(max, prop, false, first);
+            json_writer::key(text(), first, keys_.id);
+            json_writer::append(text(), prop.id());
+            if (!compact && max != Kind::Subtree)
+                step(max, prop);
+            if (min != Kind::Subtree)
+                step(min, prop);
+            if (!anonymous) {
+                json_writer::key(text(), first, keys_.name);
+                json_writer::append(text(), prop.name());
+            }
+            if (!group) {
+                json_writer::key(text(), first, keys_.value);
+                step(value, prop);
+            }
+            text() += '}';
+        }
+
+        Plan& plan_;
+        const Profile profile_;
+        const JSONKeys& keys_;
+    };
+
+    Plan plan(*this, profile);
+    Compiler compiler{plan, profile, keysOf(profile)};
+    compiler.compile(prop, false);
+    if (plan.steps_.back().kind == Plan::Step::Kind::Text)
+        compiler.close();
+    return plan;
+}
+
+void JSONSerialiser::Plan::execute(std::string& out) const
+{
+    out.clear();
+    out.reserve(texts_.size());
+    for (const Step& step : steps_) {
+        switch (step.kind) {
+        case Step::Kind::Text:
+            out.append(texts_, step.offset, step.size);
+            break;
+        case Step::Kind::Bool:
+            json_writer::append(out, static_cast<const BooleanProperty*>(step.prop)->value());
+            break;
+        case Step::Kind::Int:
+            json_writer::append(out, static_cast<const IntProperty*>(step.prop)->value());
+            break;
+        case Step::Kind::Double:
+            json_writer::append(out, static_cast<const DoubleProperty*>(step.prop)->value());
+            break;
+        case Step::Kind::String:
+            json_writer::append(out, static_cast<const StringProperty*>(step.prop)->value());
+            break;
+        case Step::Kind::IntMax:
+        case Step::Kind::IntMin:
+        case Step::Kind::DoubleMax:
+        case Step::Kind::DoubleMin: {
+            const size_t size = out.size();
+            JSONOutput output{out, profile_};
+            output.first_ = step.first;
+            if (step.kind == Step::Kind::IntMax)
+                JSONNumericSerialiser<IntProperty>().serialiseMax(output, *step.prop);
+            else if (step.kind == Step::Kind::IntMin)
+                JSONNumericSerialiser<IntProperty>().serialiseMin(output, *step.prop);
+            else if (step.kind == Step::Kind::DoubleMax)
+                JSONNumericSerialiser<DoubleProperty>().serialiseMax(output, *step.prop);
+            else
+                JSONNumericSerialiser<DoubleProperty>().serialiseMin(output, *step.prop);
+            if (step.first && out.size() != size)
+                out += ',';
+            break;
+        }
+        case Step::Kind::Subtree: {
+            JSONOutput root{out, profile_};
+            JSONOutput output(root, step.anonymous);
+            serialiser_.serialiseNode(output, *step.prop);
+            break;
+        }
+        }
+    }
+}
+
+void JSONSerialiser::serialise(const PropertyTable& table, std::string& out, Profile profile) const
+{
+    out.clear();
+    const JSONKeys& keys = keysOf(profile);
+    bool first = true;
+    out += '{';
+    json_writer::key(out, first, keys.columns);
+    out += '[';
+    // Writes the values of a column, whose array is looked up once
+    auto values = [&](const auto* data) {
+        out += '[';
+        for (size_t row = 0; row < table.size(); ++row) {
+            if (row)
+                out += ',';
+            json_writer::append(out, data[row]);
+        }
+        out += ']';
+    };
+    for (size_t column = 0; column < table.columns(); ++column) {
+        if (column)
+            out += ',';
+        switch (table.kind(column)) {
+        case PropertyTable::Kind::Bool: {
+            const unsigned char* booleans = table.booleans(column);
+            out += '[';
+            for (size_t row = 0; row < table.size(); ++row) {
+                if (row)
+                    out += ',';
+                json_writer::append(out, booleans[row] != 0);
+            }
+            out += ']';
+            break;
+        }
+        case PropertyTable::Kind::Int:
+            values(table.integers(column));
+            break;
+        case PropertyTable::Kind::Double:
+            values(table.reals(column));
+            break;
+        case PropertyTable::Kind::String:
+            values(table.strings(column));
+            break;
+        }
+    }
+    out += ']';
+    if (profile == Profile::Verbose || table.displayName() != table.name()) {
+        json_writer::key(out, first, keys.display);
+        json_writer::append(out, table.displayName());
+    }
+    json_writer::key(out, first, keys.name);
+    json_writer::append(out, table.name());
+    json_writer::key(out, first, keys.schema);
+    out += '[';
+    for (size_t column = 0; column < table.columns(); ++column) {
+        if (column)
+            out += ',';
+        JSONOutput output{out, profile};
+        serialiseNode(output, table.schema(column));
+    }
+    out += "]}";
+}
+
+namespace
+{
+
+/// Reads the values of a numeric column, which must be within the bounds of its field
+template <class T>
+void readBoundedColumn(const json& values, const Property& field, typename T::value_type* column)
+{
+    const T& bounds = field.cast<T>();
+    for (size_t row = 0; row < values.size(); ++row) {
+        column[row] = values[row].get<typename T::value_type>();
+        if (column[row] < bounds.min())
+            throw std::out_of_range("Min value was not respected in column " + field.name());
+        if (column[row] > bounds.max())
+            throw std::out_of_range("Max value was not respected in column " + field.name());
+    }
+}
+}
+
+PropertyTable JSONSerialiser::deserialiseTable(const std::string& jsonString) const
+{
+    json root = json_scanner::parse(jsonString.data(), jsonString.size());
+    const Profile profile = root.count(compactKeys.name) ? Profile::Compact : Profile::Verbose;
+    const JSONKeys& keys = keysOf(profile);
+
+    std::vector<std::unique_ptr<Property>> fields;
+    for (json& field : root.at(keys.schema))
+        fields.push_back(deserialiseNode(JSONNode(field, profile)));
+    const JSONNode node{root, profile};
+    PropertyTable table(OwnedGroupProperty(node.name(), node.displayName(), std::move(fields)));
+
+    const json& columns = root.at(keys.columns);
+    if (columns.size() != table.columns())
+        throw std::invalid_argument("Expected " + std::to_string(table.columns()) + " columns");
+    const size_t rows = columns.empty() ? 0 : columns[0].size();
+    table.reserve(rows);
+    for (size_t row = 0; row < rows; ++row)
+        table.append();
+    for (size_t column = 0; column < table.columns(); ++column) {
+        const json& values = columns[column];
+        if (values.size() != rows)
+            throw std::invalid_argument("Columns of different lengths");
+        const Property& field = table.schema(column);
+        switch (table.kind(column)) {
+        case PropertyTable::Kind::Bool: {
+            unsigned char* booleans = table.booleans(column);
+            for (size_t row = 0; row < rows; ++row)
+                booleans[row] = values[row].get<bool>();
+            break;
+        }
+        case PropertyTable::Kind::Int:
+            readBoundedColumn<IntProperty>(values, field, table.integers(column));
+            break;
+        case PropertyTable::Kind::Double:
+            readBoundedColumn<DoubleProperty>(values, field, table.reals(column));
+            break;
+        case PropertyTable::Kind::String: {
+            std::string* strings = table.strings(column);
+            for (size_t row = 0; row < rows; ++row)
+                strings[row] = values[row].get<std::string>();
+            break;
+        }
+        }
+    }
+    return table;
+}
+
+const JSONSerialiser& JSONSerialiser::shared()
 {
-    json root;
-    JSONNode node{root};
-    serialiseNode(node, prop);
-    return root.dump();
+    static const JSONSerialiser serialiser;
+    return serialiser;
 }
 }
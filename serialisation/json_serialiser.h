@@ -3,15 +3,132 @@
 #include "properties_export.h"
 #include "serialiser.h"
 
+#include <nlohmann/json_fwd.hpp>
+
 namespace property
 {
 
+class PropertyTable;
+
 class PROPERTIES_EXPORT JSONSerialiser : public Serialiser
 {
 public:
+    /// How the children of deserialised groups are built
+    enum class Materialisation {
+        /// Every child is built while deserialising
+        Eager,
+        /// Children are kept as JSON and built when first reached by find, get or an iterator. Lazy groups refer
+        /// to this serialiser, which must outlive them, and must not be read concurrently from several threads.
+        Lazy,
+        /// Every child is built, and structurally identical subtrees (e.g. the same limits below many channels)
+        /// share a single instance. The tree must then not be modified: Accessor and assign refuse to write through
+        /// its groups. Registered group types are built as usual but their own children are not shared.
+        Interned
+    };
+
+    /// Layout of the written JSON, the reader accepts all of them
+    enum class Profile {
+        /// Every key spelled out and always present
+        Verbose,
+        /// Single-letter keys, display names omitted when equal to the names
+        Compact,
+        /// As Compact, and the children of fixed-layout groups (e.g. KnownGroupProperty) are written without names.
+        /// Reading them back with their names requires their group type to be registered with its layout.
+        Positional
+    };
+
+    /// Whether serialising keeps the output of every group, to copy it as is while nothing below the group changes
+    enum class Memoisation {
+        Off,
+        /// Suits trees which are serialised repeatedly and seldom change. The kept output belongs to the tree: one
+        /// tree must not be serialised concurrently from several threads with memoisation.
+        On
+    };
+
+    /// Shape of a tree compiled once, to serialise it repeatedly: names, keys and punctuation are kept as
+    /// pre-escaped text, and only the values (and numeric bounds) are formatted on each execution. The plan refers to
+    /// the properties of the tree, which must outlive it and keep their shape, i.e. no child inserted or removed.
+    class PROPERTIES_EXPORT Plan
+    {
+    public:
+        /// Replaces the content of out with what serialise would write for the same tree and profile
+        void execute(std::string& out) const;
+
+    private:
+        friend class JSONSerialiser;
+        struct Step {
+            enum class Kind : unsigned char {
+                Text,
+                Bool,
+                Int,
+                Double,
+                String,
+                IntMax,
+                IntMin,
+                DoubleMax,
+                DoubleMin,
+                Subtree
+            };
+
+            Kind kind;
+            /// Whether a subtree is written without its name
+            bool anonymous;
+            /// Whether no member precedes a bound, which is then followed by the separator instead of preceded
+            bool first;
+            const Property* prop;
+            /// Range of texts_ written by Text steps
+            size_t offset;
+            size_t size;
+        };
+
+        Plan(const JSONSerialiser& serialiser, Profile profile) : serialiser_{serialiser}, profile_{profile} {}
+
+        const JSONSerialiser& serialiser_;
+        Profile profile_;
+        std::vector<Step> steps_;
+        std::string texts_;
+    };
+
     JSONSerialiser();
 
-    std::string serialise(const Property& prop) const;
-    std::unique_ptr<Property> deserialise(const std::string& jsonString) const;
+    /// Instance without registered groups, shared by the whole process
+    static const JSONSerialiser& shared();
+
+    std::string serialise(const Property& prop,
+                          Profile profile = Profile::Verbose,
+                          Memoisation memoisation = Memoisation::Off) const;
+    /// Replaces the content of out, whose capacity is reused: calls in a steady state do not allocate
+    void serialise(const Property& prop,
+                   std::string& out,
+                   Profile profile = Profile::Verbose,
+                   Memoisation memoisation = Memoisation::Off) const;
+    /// A property of a type which is not registered throws std::invalid_argument
+    std::unique_ptr<Property> deserialise(const std::string& jsonString,
+                                          Materialisation materialisation = Materialisation::Eager) const;
+    /// Deserialises size bytes of JSON text, e.g. from a memory mapping
+    std::unique_ptr<Property> deserialise(const char* data,
+                                          size_t size,
+                                          Materialisation materialisation = Materialisation::Eager) const;
+
+    Plan compile(const Property& prop, Profile profile = Profile::Verbose) const;
+
+    /// Writes a whole table at once: the fields of its schema, then one array of values per column
+    void serialise(const PropertyTable& table, std::string& out, Profile profile = Profile::Verbose) const;
+    /// Throws std::out_of_range for a value out of the bounds of its field
+    PropertyTable deserialiseTable(const std::string& jsonString) const;
+
+    /// Deserialises directly as T, using the factory registered for T when it is a group
+    template <class T>
+    std::unique_ptr<T> deserialise(const std::string& jsonString) const
+    {
+        return downcast<T>(deserialise(jsonString, std::type_index(typeid(T))));
+    }
+
+private:
+    friend class JSONPushParser;
+
+    std::unique_ptr<Property> deserialise(const std::string& jsonString, const std::type_index& type) const;
+    /// Deserialises a parsed document, moving its content out of it
+    std::unique_ptr<Property> deserialiseDocument(nlohmann::json& root, Materialisation materialisation) const;
 };
 }
@@ -0,0 +1,384 @@
+#include "json_shape_cache.h"
+
+#include "../basic_property.h"
+#include "../group_property.h"
+#include "../numeric_property.h"
+
+#include <nlohmann/json.hpp>
+using json = nlohmann::json;
+
+#include <limits>
+
+namespace property
+{
+
+struct JSONShapeCache::Token {
+    enum class Type : unsigned char {
+        Null,
+        Bool,
+        Integer,
+        Unsigned,
+        Real,
+        String,
+        Key,
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray
+    };
+    static constexpr size_t noSlot = std::numeric_limits<size_t>::max();
+
+    Type type;
+    /// Slot reading the value of this token, or noSlot if the token must be matched exactly
+    size_t slot;
+    union {
+        bool boolean;
+        int64_t integer;
+        uint64_t natural;
+        double real;
+    } value;
+    /// Strings and keys
+    std::string text;
+};
+
+constexpr size_t JSONShapeCache::Token::noSlot;
+
+struct JSONShapeCache::Slot {
+    enum class Kind : unsigned char { Bool, Int, Double, String };
+
+    Kind kind;
+    Property* prop;
+    /// Value read from the current document
+    bool boolean;
+    int integer;
+    double real;
+    std::string text;
+};
+
+/// Records the tokens of a document
+struct JSONShapeCache::Recorder {
+    using Type = Token::Type;
+
+    bool push(Type type)
+    {
+        tokens_.push_back({type, Token::noSlot, {}, {}});
+        return true;
+    }
+    bool null() { return push(Type::Null); }
+    bool boolean(bool value)
+    {
+        push(Type::Bool);
+        tokens_.back().value.boolean = value;
+        return true;
+    }
+    bool number_integer(json::number_integer_t value)
+    {
+        push(Type::Integer);
+        tokens_.back().value.integer = value;
+        return true;
+    }
+    bool number_unsigned(json::number_unsigned_t value)
+    {
+        // Both kinds of integers compare alike
+        if (value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+            return number_integer(static_cast<int64_t>(value));
+        push(Type::Unsigned);
+        tokens_.back().value.natural = value;
+        return true;
+    }
+    bool number_float(json::number_float_t value, const std::string& /*text*/)
+    {
+        push(Type::Real);
+        tokens_.back().value.real = value;
+        return true;
+    }
+    bool string(std::string& value)
+    {
+        push(Type::String);
+        tokens_.back().text = std::move(value);
+        return true;
+    }
+    bool binary(json::binary_t& /*value*/) { return false; }
+    bool start_object(size_t /*size*/) { return push(Type::StartObject); }
+    bool key(std::string& value)
+    {
+        push(Type::Key);
+        tokens_.back().text = std::move(value);
+        return true;
+    }
+    bool end_object() { return push(Type::EndObject); }
+    bool start_array(size_t /*size*/) { return push(Type::StartArray); }
+    bool end_array() { return push(Type::EndArray); }
+    bool parse_error(size_t /*position*/, const std::string& /*token*/, const nlohmann::detail::exception& /*error*/)
+    {
+        return false;
+    }
+
+    std::vector<Token>& tokens_;
+};
+
+/// Checks the tokens of a document against the learnt ones, and reads the values of the slots. Returning false
+/// stops the parsing at the first difference.
+struct JSONShapeCache::Matcher {
+    using Type = Token::Type;
+    using Kind = Slot::Kind;
+
+    /// Next learnt token, or null past the last one
+    const Token* next()
+    {
+        return next_ < tokens_.size() ? &tokens_[next_++] : nullptr;
+    }
+    bool structural(Type type)
+    {
+        const Token* token = next();
+        return token && token->slot == Token::noSlot && token->type == type;
+    }
+
+    bool null() { return structural(Type::Null); }
+    bool boolean(bool value)
+    {
+        const Token* token = next();
+        if (!token)
+            return false;
+        if (token->slot == Token::noSlot)
+            return token->type == Type::Bool && token->value.boolean == value;
+        Slot& slot = slots_[token->slot];
+        slot.boolean = value;
+        return slot.kind == Kind::Bool;
+    }
+    bool number_integer(json::number_integer_t value)
+    {
+        const Token* token = next();
+        if (!token)
+            return false;
+        if (token->slot == Token::noSlot)
+            return token->type == Type::Integer && token->value.integer == value;
+        Slot& slot = slots_[token->slot];
+        if (slot.kind == Kind::Double) {
+            slot.real = static_cast<double>(value);
+            return true;
+        }
+        if (slot.kind != Kind::Int || value < std::numeric_limits<int>::min() ||
+            value > std::numeric_limits<int>::max())
+            return false;
+        slot.integer = static_cast<int>(value);
+        return true;
+    }
+    bool number_unsigned(json::number_unsigned_t value)
+    {
+        if (value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+            return number_integer(static_cast<int64_t>(value));
+        const Token* token = next();
+        return token && token->slot == Token::noSlot && token->type == Type::Unsigned && token->value.natural == value;
+    }
+    bool number_float(json::number_float_t value, const std::string& /*text*/)
+    {
+        const Token* token = next();
+        if (!token)
+            return false;
+        if (token->slot == Token::noSlot)
+            return token->type == Type::Real && token->value.real == value;
+        Slot& slot = slots_[token->slot];
+        slot.real = value;
+        return slot.kind == Kind::Double;
+    }
+    bool string(std::string& value)
+    {
+        const Token* token = next();
+        if (!token)
+            return false;
+        if (token->slot == Token::noSlot)
+            return token->type == Type::String && token->text == value;
+        Slot& slot = slots_[token->slot];
+        if (slot.kind != Kind::String)
+            return false;
+        slot.text.swap(value);
+        return true;
+    }
+    bool binary(json::binary_t& /*value*/) { return false; }
+    bool start_object(size_t /*size*/) { return structural(Type::StartObject); }
+    bool key(std::string& value)
+    {
+        const Token* token = next();
+        return token && token->type == Type::Key && token->text == value;
+    }
+    bool end_object() { return structural(Type::EndObject); }
+    bool start_array(size_t /*size*/) { return structural(Type::StartArray); }
+    bool end_array() { return structural(Type::EndArray); }
+    bool parse_error(size_t /*position*/, const std::string& /*token*/, const nlohmann::detail::exception& /*error*/)
+    {
+        return false;
+    }
+
+    const std::vector<Token>& tokens_;
+    std::vector<Slot>& slots_;
+    size_t next_{0};
+};
+
+JSONShapeCache::JSONShapeCache(const JSONSerialiser& serialiser) : serialiser_{serialiser} {}
+
+JSONShapeCache::~JSONShapeCache() = default;
+
+Property& JSONShapeCache::deserialise(const char* data, size_t size)
+{
+    if (!tokens_.empty()) {
+        Matcher matcher{tokens_, slots_};
+        if (json::sax_parse(data, data + size, &matcher) && matcher.next_ == tokens_.size() && assign()) {
+            ++hits_;
+            return *tree_;
+        }
+    }
+
+    ++misses_;
+    tree_ = serialiser_.deserialise(data, size);
+    if (!learn(data, size)) {
+        tokens_.clear();
+        slots_.clear();
+    }
+    return *tree_;
+}
+
+bool JSONShapeCache::learn(const char* data, size_t size)
+{
+    tokens_.clear();
+    slots_.clear();
+    Recorder recorder{tokens_};
+    if (!json::sax_parse(data, data + size, &recorder) || tokens_.empty() ||
+        tokens_.front().type != Token::Type::StartObject)
+        return false;
+
+    // Position of the end of every token, the matching end for objects and arrays
+    std::vector<size_t> ends(tokens_.size());
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < tokens_.size(); ++i) {
+        ends[i] = i;
+        const Token::Type type = tokens_[i].type;
+        if (type == Token::Type::StartObject || type == Token::Type::StartArray) {
+            starts.push_back(i);
+        } else if (type == Token::Type::EndObject || type == Token::Type::EndArray) {
+            ends[starts.back()] = i;
+            starts.pop_back();
+        }
+    }
+
+    // As JSONSerialiser recognises the profiles
+    compact_ = false;
+    for (size_t i = 1; i < ends[0]; i = ends[i + 1] + 1) {
+        if (tokens_[i].text == "i")
+            compact_ = true;
+    }
+    return bind(0, *tree_, ends) != std::string::npos;
+}
+
+size_t JSONShapeCache::bind(size_t begin, Property& prop, const std::vector<size_t>& ends)
+{
+    const std::string& childrenKey = compact_ ? "c" : "children";
+    const std::string& valueKey = compact_ ? "v" : "value";
+
+    GroupProperty* group = dynamic_cast<GroupProperty*>(&prop);
+    Slot::Kind kind = Slot::Kind::Bool;
+    if (dynamic_cast<BooleanProperty*>(&prop))
+        kind = Slot::Kind::Bool;
+    else if (dynamic_cast<IntProperty*>(&prop))
+        kind = Slot::Kind::Int;
+    else if (dynamic_cast<DoubleProperty*>(&prop))
+        kind = Slot::Kind::Double;
+    else if (dynamic_cast<StringProperty*>(&prop))
+        kind = Slot::Kind::String;
+    else if (!group)
+        // Its value could only be matched against the learnt text, which the tree may no longer hold
+        return std::string::npos;
+
+    const size_t bound = slots_.size();
+    size_t i = begin + 1;
+    while (tokens_[i].type == Token::Type::Key) {
+        const std::string& key = tokens_[i++].text;
+        if (group && key == childrenKey && tokens_[i].type == Token::Type::StartArray) {
+            const size_t end = ends[i++];
+            for (size_t position = 0; i < end; ++position) {
+                if (tokens_[i].type != Token::Type::StartObject)
+                    return std::string::npos;
+                const std::string* name = nameOf(i, ends);
+                auto it = group->begin();
+                if (name) {
+                    it = group->find(*name);
+                } else {
+                    for (size_t skipped = 0; skipped < position && it != group->end(); ++skipped)
+                        ++it;
+                }
+                if (it == group->end())
+                    return std::string::npos;
+                // The tree belongs to the cache, its children are not const objects
+                i = bind(i, const_cast<Property&>(*it), ends);
+                if (i == std::string::npos)
+                    return std::string::npos;
+            }
+            ++i;
+        } else if (!group && key == valueKey && ends[i] == i) {
+            tokens_[i++].slot = slots_.size();
+            slots_.push_back({kind, &prop, false, 0, 0., {}});
+        } else {
+            i = ends[i] + 1;
+        }
+    }
+    // Likewise for a leaf whose value was not bound
+    if (!group && slots_.size() == bound)
+        return std::string::npos;
+    return i + 1;
+}
+
+const std::string* JSONShapeCache::nameOf(size_t begin, const std::vector<size_t>& ends) const
+{
+    const std::string& nameKey = compact_ ? "n" : "name";
+    for (size_t i = begin + 1; tokens_[i].type == Token::Type::Key; i = ends[i + 1] + 1) {
+        if (tokens_[i].text == nameKey && tokens_[i + 1].type == Token::Type::String)
+            return &tokens_[i + 1].text;
+    }
+    return nullptr;
+}
+
+bool JSONShapeCache::assign()
+{
+    // Checked first, so that a document out of bounds leaves the tree unchanged
+    for (const Slot& slot : slots_) {
+        if (slot.kind == Slot::Kind::Int) {
+            const IntProperty& prop = static_cast<const IntProperty&>(*slot.prop);
+            if (slot.integer < prop.min() || slot.integer > prop.max())
+                return false;
+        } else if (slot.kind == Slot::Kind::Double) {
+            const DoubleProperty& prop = static_cast<const DoubleProperty&>(*slot.prop);
+            if (slot.real < prop.min() || slot.real > prop.max())
+                return false;
+        }
+    }
+    for (Slot& slot : slots_) {
+        switch (slot.kind) {
+        case Slot::Kind::Bool: {
+            BooleanProperty& prop = static_cast<BooleanProperty&>(*slot.prop);
+            if (prop.value() != slot.boolean)
+                prop = slot.boolean;
+            break;
+        }
+        case Slot::Kind::Int: {
+            IntProperty& prop = static_cast<IntProperty&>(*slot.prop);
+            if (prop.value() != slot.integer)
+                prop = slot.integer;
+            break;
+        }
+        case Slot::Kind::Double: {
+            DoubleProperty& prop = static_cast<DoubleProperty&>(*slot.prop);
+            if (prop.value() != slot.real)
+                prop = slot.real;
+            break;
+        }
+        case Slot::Kind::String: {
+            StringProperty& prop = static_cast<StringProperty&>(*slot.prop);
+            if (prop.value() != slot.text)
+                prop = slot.text;
+            break;
+        }
+        }
+    }
+    return true;
+}
+}
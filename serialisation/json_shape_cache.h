@@ -0,0 +1,62 @@
+#pragma once
+
+#include "json_serialiser.h"
+#include "properties_export.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace property
+{
+
+/// Deserialises a stream of documents which mostly share one shape, i.e. the same keys in the same order, types,
+/// names and bounds, and differ only in values. The shape of a document is learnt along with the tree built from it;
+/// a following document of the same shape is only checked against it while being parsed, token by token, and its
+/// values are assigned to the tree in place. Any other document is deserialised by the serialiser, replacing the
+/// tree, and its shape is learnt instead. A shape with a leaf whose value cannot be assigned in place is not learnt,
+/// the documents of that shape always being deserialised by the serialiser.
+///
+/// Values are assigned through the properties' own operators, so that the changes reach the fingerprints, memoised
+/// outputs and change feeds; unchanged values are not assigned at all.
+class PROPERTIES_EXPORT JSONShapeCache
+{
+public:
+    explicit JSONShapeCache(const JSONSerialiser& serialiser = JSONSerialiser::shared());
+    JSONShapeCache(const JSONShapeCache&) = delete;
+    JSONShapeCache& operator=(const JSONShapeCache&) = delete;
+    ~JSONShapeCache();
+
+    /// Returns the tree kept by the cache, which remains valid until a document of another shape replaces it
+    Property& deserialise(const char* data, size_t size);
+    Property& deserialise(const std::string& jsonString) { return deserialise(jsonString.data(), jsonString.size()); }
+
+    /// Documents which matched the learnt shape, and documents deserialised by the serialiser
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+private:
+    struct Token;
+    struct Slot;
+    struct Recorder;
+    struct Matcher;
+
+    /// Records the shape of the document which tree_ was built from, returns false if it cannot be bound to the tree
+    bool learn(const char* data, size_t size);
+    /// Binds the values of the object starting at begin to prop, returns the position after the object or npos
+    size_t bind(size_t begin, Property& prop, const std::vector<size_t>& ends);
+    /// Name of the object starting at begin, or null if it is written without one
+    const std::string* nameOf(size_t begin, const std::vector<size_t>& ends) const;
+    /// Assigns the values read by the matcher, returns false (without assigning) if one is out of bounds
+    bool assign();
+
+private:
+    const JSONSerialiser& serialiser_;
+    std::unique_ptr<Property> tree_;
+    /// Whether the learnt document uses the compact keys
+    bool compact_{false};
+    std::vector<Token> tokens_;
+    std::vector<Slot> slots_;
+    size_t hits_{0};
+    size_t misses_{0};
+};
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace property
+{
+
+/// Appends JSON scalars to a string, formatted as nlohmann::json::dump would. Strings which are not valid UTF-8 throw
+/// std::invalid_argument, where nlohmann threw its type_error.
+namespace json_writer
+{
+
+inline void append(std::string& out, bool value)
+{
+    out += value ? "true" : "false";
+}
+
+inline void append(std::string& out, long long value)
+{
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* begin = end;
+    unsigned long long magnitude = value < 0 ? 0ull - static_cast<unsigned long long>(value) : value;
+    do {
+        *--begin = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0)
+        *--begin = '-';
+    out.append(begin, end);
+}
+
+inline void append(std::string& out, int value)
+{
+    append(out, static_cast<long long>(value));
+}
+
+inline void append(std::string& out, double value)
+{
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    // The fewest significant digits reading back as the same value
+    char buffer[32];
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+        if (std::strtod(buffer, nullptr) == value)
+            break;
+    }
+    // buffer holds [-]d.ddde[+-]x, whose decimal point follows the locale
+    char digits[20];
+    int count = 0;
+    const char* c = buffer;
+    if (*c == '-')
+        out += *c++;
+    for (; *c != 'e'; ++c) {
+        if (*c >= '0' && *c <= '9')
+            digits[count++] = *c;
+    }
+    while (count > 1 && digits[count - 1] == '0')
+        --count;
+    // Decimal exponent of the point after the digits, laid out as nlohmann does: positional between 1e-5 and 1e15
+    const int point = std::atoi(c + 1) + 1;
+    if (count <= point && point <= 15) {
+        out.append(digits, count);
+        out.append(point - count, '0');
+        out += ".0";
+    } else if (0 < point && point <= 15) {
+        out.append(digits, point);
+        out += '.';
+        out.append(digits + point, count - point);
+    } else if (-4 < point && point <= 0) {
+        out += "0.";
+        out.append(-point, '0');
+        out.append(digits, count);
+    } else {
+        out += digits[0];
+        if (count > 1) {
+            out += '.';
+            out.append(digits + 1, count - 1);
+        }
+        const int exponent = point - 1;
+        out += exponent < 0 ? "e-" : "e+";
+        if (std::abs(exponent) < 10)
+            out += '0';
+        out += std::to_string(std::abs(exponent));
+    }
+}
+
+/// Length of the UTF-8 sequence starting at c, 0 if it is invalid (overlong, surrogate, beyond U+10FFFF or cut)
+inline size_t utf8Sequence(const unsigned char* c, const unsigned char* end)
+{
+    auto continuation = [&](size_t i) { return c + i < end && (c[i] & 0xC0) == 0x80; };
+    if (c[0] < 0x80)
+        return 1;
+    if (c[0] >= 0xC2 && c[0] <= 0xDF)
+        return continuation(1) ? 2 : 0;
+    if (c[0] >= 0xE0 && c[0] <= 0xEF) {
+        if (!continuation(1) || !continuation(2) || (c[0] == 0xE0 && c[1] < 0xA0) || (c[0] == 0xED && c[1] > 0x9F))
+            return 0;
+        return 3;
+    }
+    if (c[0] >= 0xF0 && c[0] <= 0xF4) {
+        if (!continuation(1) || !continuation(2) || !continuation(3) || (c[0] == 0xF0 && c[1] < 0x90) ||
+            (c[0] == 0xF4 && c[1] > 0x8F))
+            return 0;
+        return 4;
+    }
+    return 0;
+}
+
+inline void append(std::string& out, const char* value, size_t size)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (const char* it = value; it != value + size; ++it) {
+        const char c = *it;
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\b':
+            out += "\\b";
+            break;
+        case '\f':
+            out += "\\f";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += hex[(c >> 4) & 0xF];
+                out += hex[c & 0xF];
+            } else if (static_cast<unsigned char>(c) < 0x80) {
+                out += c;
+            } else {
+                const auto* begin = reinterpret_cast<const unsigned char*>(it);
+                const size_t length = utf8Sequence(begin, reinterpret_cast<const unsigned char*>(value + size));
+                if (!length)
+                    throw std::invalid_argument("Invalid UTF-8 at byte " + std::to_string(it - value) + " of a string");
+                out.append(it, length);
+                it += length - 1;
+            }
+        }
+    }
+    out += '"';
+}
+
+inline void append(std::string& out, const std::string& value)
+{
+    append(out, value.data(), value.size());
+}
+
+// Without this overload, string literals would be written as booleans
+inline void append(std::string& out, const char* value)
+{
+    append(out, value, std::strlen(value));
+}
+
+/// Appends "key": with the separator required before it
+inline void key(std::string& out, bool& first, const char* name)
+{
+    if (!first)
+        out += ',';
+    first = false;
+    out += '"';
+    out += name;
+    out += "\":";
+}
+}
+}
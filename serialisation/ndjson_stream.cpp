@@ -0,0 +1,257 @@
+#include "ndjson_stream.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+namespace property
+{
+
+namespace
+{
+
+/// Reads the next non-blank line without its terminator, false at the end of the stream
+bool readLine(std::istream& in, std::string& line, size_t maxLine)
+{
+    std::streambuf& buffer = *in.rdbuf();
+    while (true) {
+        line.clear();
+        auto c = buffer.sbumpc();
+        for (; c != std::char_traits<char>::eof() && c != '\n'; c = buffer.sbumpc()) {
+            if (line.size() == maxLine)
+                throw std::length_error("Line longer than " + std::to_string(maxLine) + " bytes");
+            line += std::char_traits<char>::to_char_type(c);
+        }
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.find_first_not_of(" \t") != std::string::npos)
+            return true;
+        if (c == std::char_traits<char>::eof()) {
+            in.setstate(std::ios::eofbit);
+            return false;
+        }
+    }
+}
+}
+
+FileDescriptorBuffer::FileDescriptorBuffer(int fd, size_t size) : fd_{fd}, input_(size), output_(size)
+{
+    if (::pipe2(wake_, O_CLOEXEC | O_NONBLOCK) < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot create a pipe");
+    setg(input_.data(), input_.data(), input_.data());
+    setp(output_.data(), output_.data() + output_.size());
+}
+
+FileDescriptorBuffer::~FileDescriptorBuffer()
+{
+    flush();
+    ::close(wake_[0]);
+    ::close(wake_[1]);
+}
+
+void FileDescriptorBuffer::interrupt()
+{
+    const char wake = 0;
+    // A full pipe already wakes the readers
+    while (::write(wake_[1], &wake, 1) < 0 && errno == EINTR) {
+    }
+}
+
+void FileDescriptorBuffer::resume()
+{
+    char drained[64];
+    ssize_t size;
+    do {
+        size = ::read(wake_[0], drained, sizeof(drained));
+    } while (size > 0 || (size < 0 && errno == EINTR));
+}
+
+FileDescriptorBuffer::int_type FileDescriptorBuffer::underflow()
+{
+    pollfd descriptors[2] = {{fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+    int ready;
+    do {
+        ready = ::poll(descriptors, 2, -1);
+    } while (ready < 0 && errno == EINTR);
+    if (ready < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot poll the stream");
+    if (descriptors[1].revents)
+        return traits_type::eof();
+
+    ssize_t size;
+    do {
+        size = ::read(fd_, input_.data(), input_.size());
+    } while (size < 0 && errno == EINTR);
+    if (size < 0)
+        throw std::system_error(errno, std::generic_category(), "Cannot read the stream");
+    if (size == 0)
+        return traits_type::eof();
+    setg(input_.data(), input_.data(), input_.data() + size);
+    return traits_type::to_int_type(input_[0]);
+}
+
+FileDescriptorBuffer::int_type FileDescriptorBuffer::overflow(int_type c)
+{
+    if (!flush())
+        return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+        sputc(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+}
+
+int FileDescriptorBuffer::sync()
+{
+    return flush() ? 0 : -1;
+}
+
+bool FileDescriptorBuffer::flush()
+{
+    const char* data = pbase();
+    while (data != pptr()) {
+        const ssize_t written = ::write(fd_, data, pptr() - data);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0)
+            return false;
+        data += written;
+    }
+    setp(output_.data(), output_.data() + output_.size());
+    return true;
+}
+
+NDJSONWriter::NDJSONWriter(std::ostream& out, const JSONSerialiser& serialiser, JSONSerialiser::Profile profile)
+    : out_{out}, serialiser_{serialiser}, profile_{profile}
+{
+}
+
+void NDJSONWriter::write(const Property& prop)
+{
+    serialiser_.serialise(prop, buffer_, profile_);
+    buffer_ += '\n';
+    out_.write(buffer_.data(), buffer_.size());
+}
+
+NDJSONReader::NDJSONReader(std::istream& in, const JSONSerialiser& serialiser, size_t maxLine)
+    : in_{in}, serialiser_{serialiser}, maxLine_{maxLine}
+{
+}
+
+std::unique_ptr<Property> NDJSONReader::next()
+{
+    if (!readLine(in_, line_, maxLine_))
+        return nullptr;
+    return serialiser_.deserialise(line_);
+}
+
+NDJSONPipeline::NDJSONPipeline(
+    std::istream& in, const JSONSerialiser& serialiser, size_t workers, size_t depth, size_t maxLine)
+    : in_{in}, serialiser_{serialiser}, maxLine_{maxLine}, slots_(std::max<size_t>(depth, 1))
+{
+    threads_.emplace_back(&NDJSONPipeline::read, this);
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+        threads_.emplace_back(&NDJSONPipeline::parse, this);
+}
+
+NDJSONPipeline::~NDJSONPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    FileDescriptorBuffer* descriptor = dynamic_cast<FileDescriptorBuffer*>(in_.rdbuf());
+    if (descriptor)
+        descriptor->interrupt();
+    for (auto& thread : threads_)
+        thread.join();
+    if (descriptor)
+        descriptor->resume();
+}
+
+std::unique_ptr<Property> NDJSONPipeline::next()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Slot& slot = slots_[returned_ % slots_.size()];
+    changed_.wait(lock, [&]() { return slot.state == Slot::State::Done || (eof_ && returned_ == read_); });
+    if (slot.state != Slot::State::Done)
+        return nullptr;
+
+    std::unique_ptr<Property> prop = std::move(slot.prop);
+    std::exception_ptr error = slot.error;
+    slot.error = nullptr;
+    slot.state = Slot::State::Empty;
+    ++returned_;
+    lock.unlock();
+    changed_.notify_all();
+
+    if (error)
+        std::rethrow_exception(error);
+    return prop;
+}
+
+void NDJSONPipeline::read()
+{
+    std::string line;
+    while (true) {
+        std::exception_ptr error;
+        bool more = false;
+        try {
+            more = readLine(in_, line, maxLine_);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!more && !error) {
+            eof_ = true;
+            lock.unlock();
+            changed_.notify_all();
+            return;
+        }
+        Slot& slot = slots_[read_ % slots_.size()];
+        changed_.wait(lock, [&]() { return stopping_ || slot.state == Slot::State::Empty; });
+        if (stopping_)
+            return;
+        slot.line.swap(line);
+        // A line which could not be read is returned as an error without being parsed
+        slot.error = error;
+        slot.state = error ? Slot::State::Done : Slot::State::Read;
+        ++read_;
+        eof_ = error != nullptr;
+        lock.unlock();
+        changed_.notify_all();
+        if (error)
+            return;
+    }
+}
+
+void NDJSONPipeline::parse()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        changed_.wait(lock, [&]() { return stopping_ || parsed_ < read_ || eof_; });
+        if (stopping_ || (eof_ && parsed_ == read_))
+            return;
+
+        Slot& slot = slots_[parsed_++ % slots_.size()];
+        // Lines which could not be read are already done
+        if (slot.state != Slot::State::Read)
+            continue;
+        slot.state = Slot::State::Parsing;
+        lock.unlock();
+        try {
+            slot.prop = serialiser_.deserialise(slot.line);
+        } catch (...) {
+            slot.error = std::current_exception();
+        }
+        lock.lock();
+        slot.state = Slot::State::Done;
+        changed_.notify_all();
+    }
+}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "json_serialiser.h"
+#include "properties_export.h"
+
+#include <condition_variable>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace property
+{
+
+/// Stream buffer over a POSIX file descriptor, which it does not close. Read errors throw std::system_error.
+class PROPERTIES_EXPORT FileDescriptorBuffer : public std::streambuf
+{
+public:
+    explicit FileDescriptorBuffer(int fd, size_t size = 1 << 16);
+    ~FileDescriptorBuffer() override;
+
+    /// Makes a read blocked on the descriptor, and the following ones, return the end of the stream until resume().
+    /// Safe to call from any thread.
+    void interrupt();
+    void resume();
+
+protected:
+    int_type underflow() override;
+    int_type overflow(int_type c) override;
+    int sync() override;
+
+private:
+    bool flush();
+
+private:
+    const int fd_;
+    /// Pipe written by interrupt(), which reads wait for along with the descriptor
+    int wake_[2];
+    std::vector<char> input_;
+    std::vector<char> output_;
+};
+
+/// Writes one property per line (newline-delimited JSON)
+class PROPERTIES_EXPORT NDJSONWriter
+{
+public:
+    NDJSONWriter(std::ostream& out,
+                 const JSONSerialiser& serialiser = JSONSerialiser::shared(),
+                 JSONSerialiser::Profile profile = JSONSerialiser::Profile::Verbose);
+
+    void write(const Property& prop);
+
+private:
+    std::ostream& out_;
+    const JSONSerialiser& serialiser_;
+    const JSONSerialiser::Profile profile_;
+    std::string buffer_;
+};
+
+/// Reads one property per line, skipping blank lines. Only one line is held in memory at a time: longer lines than
+/// the given maximum throw std::length_error.
+class PROPERTIES_EXPORT NDJSONReader
+{
+public:
+    NDJSONReader(std::istream& in,
+                 const JSONSerialiser& serialiser = JSONSerialiser::shared(),
+                 size_t maxLine = 1 << 26);
+
+    /// Next property, nullptr at the end of the stream
+    std::unique_ptr<Property> next();
+
+private:
+    std::istream& in_;
+    const JSONSerialiser& serialiser_;
+    const size_t maxLine_;
+    std::string line_;
+};
+
+/// As NDJSONReader, but reading, parsing and building the properties overlap: one thread reads lines ahead while
+/// several workers deserialise them. At most depth lines or properties are held at a time, and next() still returns
+/// them in the order of the stream. Errors are rethrown by next() at the position where they occurred.
+class PROPERTIES_EXPORT NDJSONPipeline
+{
+public:
+    NDJSONPipeline(std::istream& in,
+                   const JSONSerialiser& serialiser = JSONSerialiser::shared(),
+                   size_t workers = 2,
+                   size_t depth = 64,
+                   size_t maxLine = 1 << 26);
+    /// Stops reading and waits for the threads, the stream can then be used again. A read blocked on a
+    /// FileDescriptorBuffer is interrupted; with other stream buffers, the line being read is waited for.
+    ~NDJSONPipeline();
+
+    /// Next property, nullptr at the end of the stream
+    std::unique_ptr<Property> next();
+
+private:
+    struct Slot {
+        enum class State { Empty, Read, Parsing, Done } state{State::Empty};
+        std::string line;
+        std::unique_ptr<Property> prop;
+        std::exception_ptr error;
+    };
+
+    void read();
+    void parse();
+
+private:
+    std::istream& in_;
+    const JSONSerialiser& serialiser_;
+    const size_t maxLine_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<Slot> slots_;
+    /// Sequence numbers of the lines read, handed to a worker and returned
+    size_t read_{0};
+    size_t parsed_{0};
+    size_t returned_{0};
+    bool eof_{false};
+    bool stopping_{false};
+
+    std::vector<std::thread> threads_;
+};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../group_property.h"
+
+#include <memory>
+#include <vector>
+
+namespace property
+{
+
+/// Group owning children built by a deserialiser
+class OwnedGroupProperty : public GroupProperty
+{
+public:
+    OwnedGroupProperty(const std::string& name,
+                       const std::string& displayName,
+                       std::vector<std::unique_ptr<Property>> children)
+        : GroupProperty(name, displayName), children_{std::move(children)}
+    {
+        childrenPointers_.reserve(children_.size());
+        for (const auto& child : children_)
+            childrenPointers_.push_back(child.get());
+    }
+
+    GroupPropertyIterator begin() const override { return GroupPropertyIterator{childrenPointers_.data(), 0, size()}; }
+    GroupPropertyIterator end() const override
+    {
+        return GroupPropertyIterator{childrenPointers_.data(), size(), size()};
+    }
+    size_t size() const override { return children_.size(); }
+
+private:
+    std::vector<const Property*> childrenPointers_;
+    std::vector<std::unique_ptr<Property>> children_;
+};
+
+/// Group sharing its children with other groups, built by deserialisers interning identical subtrees
+class SharedGroupProperty : public GroupProperty
+{
+public:
+    SharedGroupProperty(const std::string& name,
+                        const std::string& displayName,
+                        std::vector<std::shared_ptr<const Property>> children)
+        : GroupProperty(name, displayName), children_{std::move(children)}
+    {
+        childrenPointers_.reserve(children_.size());
+        for (const auto& child : children_)
+            childrenPointers_.push_back(child.get());
+    }
+
+    GroupPropertyIterator begin() const override { return GroupPropertyIterator{childrenPointers_.data(), 0, size()}; }
+    GroupPropertyIterator end() const override
+    {
+        return GroupPropertyIterator{childrenPointers_.data(), size(), size()};
+    }
+    size_t size() const override { return children_.size(); }
+    bool writable() const override { return false; }
+
+private:
+    std::vector<const Property*> childrenPointers_;
+    std::vector<std::shared_ptr<const Property>> children_;
+};
+}
@@ -1,21 +1,32 @@
 #include "serialiser.h"
 
 #include <cassert>
+#include <stdexcept>
 
 namespace property
 {
 
-std::unique_ptr<Property> Serialiser::deserialiseNode(Node& node) const
+std::unique_ptr<Property> Serialiser::deserialiseNode(const Node& node) const
 {
+    // The type comes from the data, which may be anything
     auto it = serialisers_.find(node.id());
-    assert(it != serialisers_.end());
+    if (it == serialisers_.end())
+        throw std::invalid_argument("Unknown property type: " + node.id());
     return it->second->deserialise(node);
 }
 
-void Serialiser::serialiseNode(Node& node, const Property& prop) const
+std::unique_ptr<Property> Serialiser::deserialiseNode(const Node& node, const std::type_index& type) const
+{
+    auto it = factories_.find(type);
+    if (it == factories_.end())
+        return deserialiseNode(node);
+    return it->second.build(GroupReader(*this, node, it->second.layout));
+}
+
+void Serialiser::serialiseNode(Output& out, const Property& prop) const
 {
     auto it = serialisers_.find(prop.id());
     assert(it != serialisers_.end());
-    it->second->serialise(node, prop);
+    it->second->serialise(out, prop);
 }
 }
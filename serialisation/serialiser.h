@@ -5,36 +5,69 @@
 #include "../numeric_property.h"
 #include "../property.h"
 
+#include <algorithm>
+#include <functional>
 #include <map>
 #include <memory>
+#include <typeindex>
+#include <vector>
 
 namespace property
 {
 
+/// Serialised form of a property. Strings are returned by reference to the underlying document and only copied
+/// when the property itself is constructed.
 struct Node {
     virtual ~Node() = default;
 
-    virtual std::string id() = 0;
+    virtual const std::string& id() const = 0;
+    virtual const std::string& name() const = 0;
+    /// Empty if the node has no display name
+    virtual const std::string& displayName() const = 0;
+    /// Child of a group node, nullptr if there is none with that name. Formats which can omit the names of
+    /// children use the one at the given position instead, if any (none for npos).
+    virtual std::unique_ptr<Node> child(const std::string& name, size_t position) const = 0;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
 
     template <class T>
     T& cast()
     {
         return dynamic_cast<T&>(*this);
     }
+    template <class T>
+    const T& cast() const
+    {
+        return dynamic_cast<const T&>(*this);
+    }
 };
 
+/// Destination of a serialised property
+struct Output {
+    virtual ~Output() = default;
+
+    template <class T>
+    T& cast()
+    {
+        return dynamic_cast<T&>(*this);
+    }
+};
+
+/// Stateless, hence safe to use from several threads at once
 class PropertySerialiser
 {
 public:
-    virtual std::unique_ptr<Property> deserialise(Node& node) = 0;
-    virtual void serialise(Node& node, const Property& prop) = 0;
+    virtual ~PropertySerialiser() = default;
+
+    virtual std::unique_ptr<Property> deserialise(const Node& node) const = 0;
+    virtual void serialise(Output& out, const Property& prop) const = 0;
 };
 
 template <class String, class Bool, class Int, class Double, class Group>
 struct Mapper {
     void fill(std::map<std::string, std::unique_ptr<PropertySerialiser>>& serialisers,
-              std::function<std::unique_ptr<Property>(Node& node)> deserialiseChild,
-              std::function<void(Node& node, const Property& prop)> serialiseChild) const
+              std::function<std::unique_ptr<Property>(const Node& node)> deserialiseChild,
+              std::function<void(Output& out, const Property& prop)> serialiseChild) const
     {
         map<String, StringProperty>(serialisers);
         map<Bool, BooleanProperty>(serialisers);
@@ -55,22 +88,94 @@ struct Mapper {
     }
 };
 
-class Serialiser
+class GroupReader;
+
+/// Once constructed and its groups registered, a serialiser can be shared: all its const members may be called
+/// concurrently from several threads.
+class PROPERTIES_EXPORT Serialiser
 {
 public:
+    /// Builds a registered group type directly from its serialised node
+    using GroupFactory = std::function<std::unique_ptr<Property>(const GroupReader& reader)>;
+
     template <class Map>
     Serialiser(const Map& mapper)
     {
         mapper.fill(serialisers_,
-                    [this](Node& node) { return deserialiseNode(node); },
-                    [this](Node& node, const Property& prop) { serialiseNode(node, prop); });
+                    [this](const Node& node) { return deserialiseNode(node); },
+                    [this](Output& out, const Property& prop) { serialiseNode(out, prop); });
+    }
+    // The group serialisers refer back to this instance
+    Serialiser(const Serialiser&) = delete;
+    Serialiser& operator=(const Serialiser&) = delete;
+
+    /// Registers the factory used to deserialise groups as T, both for deserialise<T> and for the children read
+    /// through GroupReader::get<T>. The layout lists the names of the children in order, for formats which omit
+    /// them. Registration must be done before the serialiser is used.
+    template <class T>
+    void registerGroup(std::function<std::unique_ptr<T>(const GroupReader& reader)> factory,
+                       std::vector<std::string> layout = {})
+    {
+        static_assert(std::is_base_of<GroupProperty, T>::value, "Only groups can be registered");
+        factories_[std::type_index(typeid(T))] = Factory{
+            [factory](const GroupReader& reader) -> std::unique_ptr<Property> { return factory(reader); },
+            std::move(layout)};
+    }
+
+    /// Takes ownership of a property as its concrete type, throws std::bad_cast if it has another type
+    template <class T>
+    static std::unique_ptr<T> downcast(std::unique_ptr<Property> prop)
+    {
+        T& cast = prop->cast<T>();
+        prop.release();
+        return std::unique_ptr<T>(&cast);
     }
 
 protected:
-    std::unique_ptr<Property> deserialiseNode(Node& node) const;
-    void serialiseNode(Node& node, const Property& prop) const;
+    friend class GroupReader;
+
+    std::unique_ptr<Property> deserialiseNode(const Node& node) const;
+    /// Uses the factory registered for the type if any, the generic deserialisation otherwise
+    std::unique_ptr<Property> deserialiseNode(const Node& node, const std::type_index& type) const;
+    void serialiseNode(Output& out, const Property& prop) const;
 
 private:
+    struct Factory {
+        GroupFactory build;
+        std::vector<std::string> layout;
+    };
+
     std::map<std::string, std::unique_ptr<PropertySerialiser>> serialisers_;
+    std::map<std::type_index, Factory> factories_;
+};
+
+/// Access to a group node for the factories of registered group types
+class GroupReader
+{
+public:
+    GroupReader(const Serialiser& serialiser, const Node& node, const std::vector<std::string>& layout)
+        : serialiser_{serialiser}, node_{node}, layout_{layout}
+    {
+    }
+
+    const std::string& name() const { return node_.name(); }
+    const std::string& displayName() const { return node_.displayName(); }
+
+    template <class T>
+    std::unique_ptr<T> get(const std::string& name) const
+    {
+        // Only a name of the layout has a position, unnamed children being matched to nothing else
+        const auto it = std::find(layout_.begin(), layout_.end(), name);
+        const size_t position = it != layout_.end() ? static_cast<size_t>(it - layout_.begin()) : Node::npos;
+        std::unique_ptr<Node> child = node_.child(name, position);
+        if (!child)
+            throw std::out_of_range("No child with name: " + name);
+        return Serialiser::downcast<T>(serialiser_.deserialiseNode(*child, std::type_index(typeid(T))));
+    }
+
+private:
+    const Serialiser& serialiser_;
+    const Node& node_;
+    const std::vector<std::string>& layout_;
 };
 }
@@ -0,0 +1,51 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <accessor.h>
+#include <serialisation/json_serialiser.h>
+
+namespace property
+{
+
+TEST_CASE("Accessor")
+{
+    JSONSerialiser serialiser;
+    auto root = serialiser.deserialise(
+        R"JSON({"children":[{"children":[{"id":"int","name":"min","value":-3},{"id":"int","max":10,"name":"max","value":7}],"id":"group","name":"limits"},{"id":"string","name":"label","value":"M1"}],"id":"group","name":"motor"})JSON");
+    GroupProperty& motor = root->cast<GroupProperty>();
+
+    SECTION("Resolve")
+    {
+        CHECK(resolve(motor, "limits.max").name() == "max");
+        CHECK(resolve(motor, "label").cast<StringProperty>().value() == "M1");
+        CHECK_THROWS_AS(resolve(motor, "limits.mid"), std::out_of_range);
+        CHECK_THROWS_AS(resolve(motor, "label.max"), std::bad_cast);
+    }
+
+    SECTION("Read and write")
+    {
+        Accessor<IntProperty> max(motor, "limits.max");
+        CHECK(max.value() == 7);
+        max = 9;
+        CHECK(max.value() == 9);
+        CHECK(motor.get<GroupProperty>("limits").get<IntProperty>("max").value() == 9);
+        CHECK_THROWS_AS(max = 11, std::out_of_range);
+        CHECK(max.value() == 9);
+
+        Accessor<StringProperty> label(motor, "label");
+        label = "M2";
+        CHECK(motor.get<StringProperty>("label").value() == "M2");
+        CHECK_THROWS_AS(Accessor<DoubleProperty>(motor, "limits.min"), std::bad_cast);
+    }
+
+    SECTION("Known group")
+    {
+        XYProperty xy("xy", IntProperty("x", 1), IntProperty("y", 2));
+        Accessor<IntProperty> y(xy, "y");
+        y = 5;
+        CHECK(xy.y().value() == 5);
+        CHECK(&y.property() == &xy.y());
+    }
+}
+}
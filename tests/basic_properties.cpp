@@ -5,6 +5,25 @@
 namespace property
 {
 
+namespace
+{
+/// Value type which Hasher cannot hash, streamed by its own operators
+enum class Colour { Red, Green };
+
+std::ostream& operator<<(std::ostream& out, Colour colour)
+{
+    return out << (colour == Colour::Red ? "red" : "green");
+}
+std::wostream& operator<<(std::wostream& out, Colour colour)
+{
+    return out << (colour == Colour::Red ? L"red" : L"green");
+}
+}
+
+using ColourProperty = BasicProperty<Colour>;
+template <>
+const std::string ColourProperty::identifier = "colour";
+
 template <class T>
 void checkBasicProperty(const T& prop, const typename T::value_type& value)
 {
@@ -29,6 +48,9 @@ void testBasicPropertyCopyConstructor(const typename T::value_type& value)
     T original("name", value, "display");
     T prop(original);
     checkBasicProperty(prop, value);
+    CHECK(prop.descriptor() == original.descriptor());
+    CHECK(T("name", original).descriptor() == original.descriptor());
+    checkBasicProperty(T(original.descriptor(), value), value);
 }
 
 template <class T>
@@ -170,4 +192,15 @@ TEST_CASE("Test WStringProperty")
 {
     testBasicProperty<WStringProperty>(L"Asdf", L"Qwer");
 }
+
+TEST_CASE("Test BasicProperty of another type")
+{
+    testBasicProperty<ColourProperty>(Colour::Red, Colour::Green);
+
+    INFO("Fingerprinted in the string form of the value");
+    const ColourProperty red("name", Colour::Red, "display");
+    CHECK(red.fingerprint() == ColourProperty("name", Colour::Red, "other").fingerprint());
+    CHECK(red.fingerprint() != ColourProperty("name", Colour::Green, "display").fingerprint());
+    CHECK(red.fingerprint() != ColourProperty("other", Colour::Red, "display").fingerprint());
+}
 }
@@ -0,0 +1,70 @@
+#include <catch2/catch.hpp>
+
+#include "bool2property.h"
+#include "xyproperty.h"
+
+#include <dynamic_group_property.h>
+#include <serialisation/binary_serialiser.h>
+
+namespace property
+{
+
+TEST_CASE("Binary serialisation")
+{
+    const BinarySerialiser& serialiser = BinarySerialiser::shared();
+
+    SECTION("Leaves")
+    {
+        CHECK(StringProperty("s", "Value", "S") == StringProperty::convert(*serialiser.deserialise(
+                                                       serialiser.serialise(StringProperty("s", "Value", "S")))));
+        CHECK(BooleanProperty("b", true) ==
+              BooleanProperty::convert(*serialiser.deserialise(serialiser.serialise(BooleanProperty("b", true)))));
+        CHECK(IntProperty("i", -300, -1000, 7) ==
+              IntProperty::convert(*serialiser.deserialise(serialiser.serialise(IntProperty("i", -300, -1000, 7)))));
+        CHECK(DoubleProperty("d", 0.1) ==
+              DoubleProperty::convert(*serialiser.deserialise(serialiser.serialise(DoubleProperty("d", 0.1)))));
+        CHECK(serialiser.serialise(IntProperty("i", 3)) == std::string("i\1i\0\0\6", 6));
+    }
+
+    SECTION("Groups")
+    {
+        const XYProperty xy("XY", IntProperty("x", 3), IntProperty("y", 1, -3, 9, "MyY"), "MyXY");
+        auto read = serialiser.deserialise(serialiser.serialise(xy));
+        CHECK(XYProperty::convert(*read) == xy);
+        CHECK(read->displayName() == "MyXY");
+        CHECK(read->cast<GroupProperty>().get<IntProperty>("y").displayName() == "MyY");
+
+        BinarySerialiser typed;
+        typed.registerGroup<XYProperty>([](const GroupReader& reader) {
+            return std::make_unique<XYProperty>(
+                reader.name(), *reader.get<IntProperty>("x"), *reader.get<IntProperty>("y"), reader.displayName());
+        });
+        CHECK(*typed.deserialise<XYProperty>(serialiser.serialise(xy)) == xy);
+
+        // The leaves of one field share their descriptor
+        DynamicGroupProperty pair("pair");
+        pair.insert(std::make_unique<XYProperty>("a", IntProperty("x", 1), IntProperty("y", 2, -3, 9, "MyY")));
+        pair.insert(std::make_unique<XYProperty>("b", IntProperty("x", 3), IntProperty("y", 4, -3, 9, "MyY")));
+        auto copy = serialiser.deserialise(serialiser.serialise(pair));
+        const GroupProperty& a = copy->cast<GroupProperty>().get<GroupProperty>("a");
+        const GroupProperty& b = copy->cast<GroupProperty>().get<GroupProperty>("b");
+        CHECK(a.get<IntProperty>("y").descriptor() == b.get<IntProperty>("y").descriptor());
+        CHECK(a.get<IntProperty>("x").descriptor() != a.get<IntProperty>("y").descriptor());
+    }
+
+    SECTION("Truncated")
+    {
+        const std::string data =
+            serialiser.serialise(Bool2Property("b", BooleanProperty("a", true), BooleanProperty("b", false)));
+        for (size_t size = 0; size < data.size(); ++size)
+            CHECK_THROWS_AS(serialiser.deserialise(data.data(), size), std::runtime_error);
+
+        // A count of children which cannot fit in the data is not allocated
+        std::string empty = serialiser.serialise(DynamicGroupProperty("g"));
+        REQUIRE(empty.back() == '\0');
+        empty.back() = '\xFF';
+        empty += std::string(7, '\xFF') + '\x0F';
+        CHECK_THROWS_AS(serialiser.deserialise(empty), std::runtime_error);
+    }
+}
+}
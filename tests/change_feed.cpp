@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <accessor.h>
+#include <basic_property.h>
+#include <change_feed.h>
+
+#include <thread>
+
+namespace property
+{
+
+TEST_CASE("Change feed")
+{
+    XYProperty xy("xy", IntProperty("x", 1), IntProperty("y", 2));
+    Accessor<IntProperty> x(xy, "x");
+    Accessor<IntProperty> y(xy, "y");
+    ChangeBatch batch;
+
+    SECTION("Coalesced batches")
+    {
+        ChangeFeed feed;
+        feed.watch(xy);
+        CHECK(!feed.poll(batch));
+
+        x = 3;
+        y = 4;
+        x = 5;
+        REQUIRE(feed.poll(batch));
+        REQUIRE(batch.changes.size() == 2);
+        CHECK(batch.changes[0].property == &xy.x());
+        CHECK(batch.changes[0].kind == ChangeRecord::Kind::Int);
+        CHECK(batch.changes[0].value.integer == 5);
+        CHECK(batch.changes[1].property == &xy.y());
+        CHECK(batch.changes[1].value.integer == 4);
+        CHECK(!batch.overflowed);
+        CHECK(!feed.poll(batch));
+
+        feed.unwatch(xy.x());
+        x = 6;
+        CHECK(!feed.poll(batch));
+    }
+
+    SECTION("Overflow")
+    {
+        ChangeFeed feed(2);
+        feed.watch(xy);
+        for (int i = 0; i < 5; ++i)
+            x = i;
+        REQUIRE(feed.poll(batch));
+        CHECK(batch.overflowed);
+        CHECK(batch.changes.size() == 1);
+    }
+
+    SECTION("Other types")
+    {
+        ChangeFeed feed;
+        StringProperty label("label", "a");
+        DoubleProperty speed("speed", 1.5);
+        feed.watch(label);
+        feed.watch(speed);
+        label = "b";
+        speed = 2.5;
+        REQUIRE(feed.poll(batch));
+        REQUIRE(batch.changes.size() == 2);
+        CHECK(batch.changes[0].kind == ChangeRecord::Kind::Other);
+        CHECK(batch.changes[1].kind == ChangeRecord::Kind::Double);
+        CHECK(batch.changes[1].value.real == 2.5);
+        feed.unwatch(label);
+        feed.unwatch(speed);
+    }
+
+    SECTION("Destroyed before the feed")
+    {
+        ChangeFeed feed;
+        {
+            IntProperty count("count", 0);
+            feed.watch(count);
+            count = 1;
+        }
+        // The pending change of the destroyed property is dropped, not reported with a dangling pointer
+        CHECK(!feed.poll(batch));
+
+        IntProperty other("other", 0);
+        feed.watch(other);
+        other = 2;
+        REQUIRE(feed.poll(batch));
+        REQUIRE(batch.changes.size() == 1);
+        CHECK(batch.changes[0].property == &other);
+        CHECK(batch.changes[0].value.integer == 2);
+    }
+
+    SECTION("Subscriber thread")
+    {
+        ChangeFeed feed;
+        feed.watch(xy);
+        int last = 0;
+        std::thread subscriber([&]() {
+            ChangeBatch received;
+            while (last != 1000) {
+                if (feed.wait(received, std::chrono::milliseconds(1000))) {
+                    for (const auto& change : received.changes)
+                        last = static_cast<int>(change.value.integer);
+                } else {
+                    break;
+                }
+            }
+        });
+        for (int i = 1; i <= 1000; ++i)
+            x = i;
+        subscriber.join();
+        CHECK(last == 1000);
+    }
+}
+}
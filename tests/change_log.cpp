@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+
+#include "temporary_directory.h"
+
+#include <accessor.h>
+#include <persistence/change_log.h>
+#include <persistence/file_store.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace property
+{
+
+TEST_CASE("Change log")
+{
+    TemporaryDirectory directory;
+    const std::string path = directory.path_ + "/tree.json";
+    writeAtomically(
+        path,
+        R"JSON({"children":[{"children":[{"id":"int","name":"max","value":7}],"id":"group","name":"limits"},{"id":"string","name":"label","value":"M1"}],"id":"group","name":"motor"})JSON");
+
+    {
+        ChangeLog log(path);
+        auto tree = log.load();
+        Accessor<IntProperty> max(tree->cast<GroupProperty>(), "limits.max");
+        max = 8;
+        log.record("limits.max", max.property());
+        max = 9;
+        log.record("limits.max", max.property());
+        log.record("label", StringProperty("label", "M2"));
+        CHECK(log.size() > 0);
+    }
+
+    SECTION("Replay")
+    {
+        ChangeLog log(path);
+        auto tree = log.load();
+        const GroupProperty& motor = tree->cast<GroupProperty>();
+        CHECK(motor.get<GroupProperty>("limits").get<IntProperty>("max").value() == 9);
+        CHECK(motor.get<StringProperty>("label").value() == "M2");
+    }
+
+    SECTION("Truncated record")
+    {
+        const std::string log = path + ".log";
+        struct stat status;
+        REQUIRE(::stat(log.c_str(), &status) == 0);
+        REQUIRE(::truncate(log.c_str(), status.st_size - 1) == 0);
+        auto tree = ChangeLog(path).load();
+        CHECK(resolve(tree->cast<GroupProperty>(), "limits.max").cast<IntProperty>().value() == 9);
+        CHECK(resolve(tree->cast<GroupProperty>(), "label").cast<StringProperty>().value() == "M1");
+    }
+
+    SECTION("Compaction")
+    {
+        ChangeLog log(path);
+        auto tree = log.load();
+        log.compact(*tree);
+        log.record("label", StringProperty("label", "M3"));
+        log.wait();
+        CHECK(::access((path + ".log.compacting").c_str(), F_OK) != 0);
+        CHECK(log.size() < 20);
+
+        auto reloaded = ChangeLog(path).load();
+        CHECK(resolve(reloaded->cast<GroupProperty>(), "limits.max").cast<IntProperty>().value() == 9);
+        CHECK(resolve(reloaded->cast<GroupProperty>(), "label").cast<StringProperty>().value() == "M3");
+    }
+
+    SECTION("Failed compactions")
+    {
+        std::string snapshot;
+        {
+            MappedFile file(path);
+            snapshot.assign(file.data(), file.size());
+        }
+        // The snapshot cannot be replaced by a file while a directory has its name
+        REQUIRE(::unlink(path.c_str()) == 0);
+        REQUIRE(::mkdir(path.c_str(), 0755) == 0);
+
+        ChangeLog log(path);
+        log.compact(IntProperty("unused", 0));
+        CHECK_THROWS_AS(log.wait(), std::system_error);
+        log.record("label", StringProperty("label", "M3"));
+        log.compact(IntProperty("unused", 0));
+        CHECK_THROWS_AS(log.wait(), std::system_error);
+        log.record("limits.max", IntProperty("max", 10));
+
+        REQUIRE(::rmdir(path.c_str()) == 0);
+        writeAtomically(path, snapshot);
+        auto reloaded = ChangeLog(path).load();
+        CHECK(resolve(reloaded->cast<GroupProperty>(), "limits.max").cast<IntProperty>().value() == 10);
+        CHECK(resolve(reloaded->cast<GroupProperty>(), "label").cast<StringProperty>().value() == "M3");
+
+        // Every record is dropped once a compaction succeeds
+        log.compact(*reloaded);
+        log.wait();
+        CHECK(::access((path + ".log.compacting").c_str(), F_OK) != 0);
+        CHECK(log.size() == 0);
+        CHECK(ChangeLog(path).load()->equals(*reloaded));
+    }
+}
+}
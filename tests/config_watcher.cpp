@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+
+#include "temporary_directory.h"
+
+#include <accessor.h>
+#include <dynamic_group_property.h>
+#include <overlay_group_property.h>
+#include <persistence/config_watcher.h>
+#include <persistence/file_store.h>
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace property
+{
+
+TEST_CASE("Config watcher")
+{
+    TemporaryDirectory directory;
+    const std::string path = directory.path_ + "/config.json";
+    const std::string json =
+        R"JSON({"children":[{"children":[{"id":"int","max":10,"name":"max","value":5},{"id":"int","name":"min","value":0}],"id":"group","name":"limits"},{"id":"string","name":"label","value":"A"}],"id":"group","name":"config"})JSON";
+    writeAtomically(path, json);
+
+    auto tree = FileStore(path).load();
+    GroupProperty& root = tree->cast<GroupProperty>();
+    Accessor<IntProperty> max(root, "limits.max");
+    Accessor<StringProperty> label(root, "label");
+    const Property* limits = &root.get<GroupProperty>("limits");
+
+    std::unique_ptr<Property> restructured;
+    ConfigWatcher watcher(path, root, [&](std::unique_ptr<Property> loaded) { restructured = std::move(loaded); });
+    CHECK(watcher.poll() == 0);
+
+    SECTION("Values changed in place")
+    {
+        std::string edited = json;
+        edited.replace(edited.find("\"value\":5"), 9, "\"value\":7");
+        writeAtomically(path, edited);
+        CHECK(watcher.poll(std::chrono::milliseconds(5000)) == 1);
+        CHECK(max.value() == 7);
+        CHECK(label.value() == "A");
+        CHECK(&root.get<GroupProperty>("limits") == limits);
+
+        // Written in place, without renaming
+        edited.replace(edited.find("\"A\""), 3, "\"B\"");
+        edited.replace(edited.find("\"max\":10"), 8, "\"max\":20");
+        std::ofstream(path) << edited;
+        CHECK(watcher.poll(std::chrono::milliseconds(5000)) == 2);
+        CHECK(max.value() == 7);
+        CHECK(resolve(root, "limits.max").cast<IntProperty>().max() == 20);
+        CHECK(label.value() == "B");
+        CHECK(!restructured);
+
+        // Other files of the directory are ignored
+        writeAtomically(directory.path_ + "/other.json", json);
+        CHECK(watcher.poll(std::chrono::milliseconds(100)) == 0);
+    }
+
+    SECTION("Restructured")
+    {
+        std::string edited = json;
+        edited.replace(edited.find(R"({"id":"string")"), 0, R"({"id":"bool","name":"enabled","value":true},)");
+        writeAtomically(path, edited);
+        CHECK(watcher.poll(std::chrono::milliseconds(5000)) == 0);
+        REQUIRE(restructured);
+        CHECK(restructured->cast<GroupProperty>().size() == 3);
+        CHECK(root.size() == 2);
+    }
+
+    SECTION("Changes checked before the first is applied")
+    {
+        // The limits of this tree are an overlay, which cannot be written
+        DynamicGroupProperty layer("limits");
+        layer.insert(std::make_unique<IntProperty>("max", 5, -IntProperty::max_value, 10));
+        layer.insert(std::make_unique<IntProperty>("min", 0));
+        DynamicGroupProperty overlaid("config");
+        overlaid.insert(std::make_unique<StringProperty>("label", "A"));
+        overlaid.insert(std::make_unique<OverlayGroupProperty>("limits", std::vector<const GroupProperty*>{&layer}));
+        ConfigWatcher overlaidWatcher(path, overlaid);
+
+        // The label comes first, and would be assigned before the limits are found to be unwritable
+        writeAtomically(
+            path,
+            R"JSON({"children":[{"id":"string","name":"label","value":"B"},{"children":[{"id":"int","max":10,"name":"max","value":7},{"id":"int","name":"min","value":0}],"id":"group","name":"limits"}],"id":"group","name":"config"})JSON");
+        CHECK_THROWS_AS(overlaidWatcher.poll(std::chrono::milliseconds(5000)), std::invalid_argument);
+        CHECK(overlaid.get<StringProperty>("label").value() == "A");
+        CHECK(layer.get<IntProperty>("max").value() == 5);
+    }
+
+    SECTION("Directory replaced")
+    {
+        std::string edited = json;
+        edited.replace(edited.find("\"value\":5"), 9, "\"value\":7");
+        REQUIRE(std::remove(path.c_str()) == 0);
+        REQUIRE(std::remove(directory.path_.c_str()) == 0);
+        REQUIRE(::mkdir(directory.path_.c_str(), 0700) == 0);
+        writeAtomically(path, edited);
+        CHECK(watcher.poll(std::chrono::milliseconds(5000)) == 1);
+        CHECK(max.value() == 7);
+
+        // Watched again
+        edited.replace(edited.find("\"A\""), 3, "\"B\"");
+        writeAtomically(path, edited);
+        CHECK(watcher.poll(std::chrono::milliseconds(5000)) == 1);
+        CHECK(label.value() == "B");
+    }
+
+    SECTION("Invalid content")
+    {
+        std::ofstream(path) << "{";
+        CHECK_THROWS(watcher.poll(std::chrono::milliseconds(5000)));
+        CHECK(max.value() == 5);
+    }
+}
+}
@@ -1,9 +1,15 @@
 #include <catch2/catch.hpp>
 
 #include "bool2property.h"
+#include "xyproperty.h"
 
+#include <accessor.h>
 #include <basic_property.h>
+#include <dynamic_group_property.h>
+#include <numeric_property.h>
+#include <serialisation/interner.h>
 #include <serialisation/json_serialiser.h>
+#include <serialisation/json_shape_cache.h>
 
 namespace property
 {
@@ -27,6 +33,19 @@ TEST_CASE("Deserialise from JSON")
                   R"JSON({"display":"MyBool","id":"bool","name":"Boole","value":true})JSON")));
     }
 
+    SECTION("Int with default limits")
+    {
+        CHECK(IntProperty("Int", 3) ==
+              IntProperty::convert(*serialiser.deserialise(R"JSON({"id":"int","name":"Int","value":3})JSON")));
+    }
+
+    SECTION("Double with min/max")
+    {
+        CHECK(DoubleProperty("Double", 3.11, -4.2, 7.333, "MyDouble") ==
+              DoubleProperty::convert(*serialiser.deserialise(
+                  R"JSON({"display":"MyDouble","id":"double","max":7.333,"min":-4.2,"name":"Double","value":3.11})JSON")));
+    }
+
     SECTION("Group")
     {
         CHECK(
@@ -35,5 +54,200 @@ TEST_CASE("Deserialise from JSON")
                 R"JSON({"children":[{"display":"a","id":"bool","name":"a","value":true},{"display":"b","id":"bool","name":"b","value":false}],"display":"XY","id":"group","name":"XY"})JSON")));
     }
 
+    SECTION("Typed group")
+    {
+        serialiser.registerGroup<XYProperty>([](const GroupReader& reader) {
+            return std::make_unique<XYProperty>(
+                reader.name(), *reader.get<IntProperty>("x"), *reader.get<IntProperty>("y"), reader.displayName());
+        });
+        auto xy = serialiser.deserialise<XYProperty>(
+            R"JSON({"children":[{"id":"int","name":"y","value":1},{"id":"int","max":9,"name":"x","value":3}],"display":"MyXY","id":"group","name":"XY"})JSON");
+        CHECK(*xy == XYProperty("XY", IntProperty("x", 3, -IntProperty::max_value, 9), IntProperty("y", 1)));
+        CHECK(xy->displayName() == "MyXY");
+
+        CHECK_THROWS_AS(serialiser.deserialise<XYProperty>(
+                            R"JSON({"children":[{"id":"int","name":"x","value":3}],"id":"group","name":"XY"})JSON"),
+                        std::out_of_range);
+        CHECK_THROWS_AS(serialiser.deserialise<Bool2Property>(
+                            R"JSON({"children":[],"display":"XY","id":"group","name":"XY"})JSON"),
+                        std::bad_cast);
+        // Without a layout, unnamed children cannot be matched
+        CHECK_THROWS_AS(serialiser.deserialise<XYProperty>(
+                            R"JSON({"children":[{"id":"int","value":3},{"id":"int","value":1}],"id":"group","name":"XY"})JSON"),
+                        std::out_of_range);
+    }
+
+    SECTION("Compact")
+    {
+        CHECK(IntProperty("Int", 3, -4, 7, "MyInt") ==
+              IntProperty::convert(*serialiser.deserialise(
+                  R"JSON({"d":"MyInt","h":7,"i":"int","l":-4,"n":"Int","v":3})JSON")));
+
+        const Bool2Property group("XY", BooleanProperty("x", true), BooleanProperty("y", false));
+        CHECK(group == Bool2Property::convert(*serialiser.deserialise(
+                           serialiser.serialise(group, JSONSerialiser::Profile::Compact))));
+        CHECK(group == Bool2Property::convert(*serialiser.deserialise(
+                           serialiser.serialise(group, JSONSerialiser::Profile::Compact),
+                           JSONSerialiser::Materialisation::Lazy)));
+    }
+
+    SECTION("Positional")
+    {
+        serialiser.registerGroup<XYProperty>(
+            [](const GroupReader& reader) {
+                return std::make_unique<XYProperty>(
+                    reader.name(), *reader.get<IntProperty>("x"), *reader.get<IntProperty>("y"), reader.displayName());
+            },
+            {"x", "y"});
+        const XYProperty xy("XY", IntProperty("x", 3), IntProperty("y", 1, -3, 9, "MyY"));
+        auto read = serialiser.deserialise<XYProperty>(serialiser.serialise(xy, JSONSerialiser::Profile::Positional));
+        CHECK(*read == xy);
+        CHECK(read->y().displayName() == "MyY");
+    }
+
+    SECTION("Positional, name missing from the layout")
+    {
+        serialiser.registerGroup<XYProperty>(
+            [](const GroupReader& reader) {
+                return std::make_unique<XYProperty>(
+                    reader.name(), *reader.get<IntProperty>("x"), *reader.get<IntProperty>("y"), reader.displayName());
+            },
+            {"x"});
+        CHECK_THROWS_AS(serialiser.deserialise<XYProperty>(
+                            R"JSON({"children":[{"id":"int","value":3},{"id":"int","value":1}],"id":"group","name":"XY"})JSON"),
+                        std::out_of_range);
+    }
+
+    SECTION("Lazy group")
+    {
+        auto prop = serialiser.deserialise(
+            R"JSON({"children":[{"display":"a","id":"bool","name":"a","value":true},{"children":[{"display":"c","id":"string","name":"c","value":"C"}],"display":"B","id":"group","name":"b"}],"display":"XY","id":"group","name":"XY"})JSON",
+            JSONSerialiser::Materialisation::Lazy);
+        const GroupProperty& group = prop->cast<GroupProperty>();
+        CHECK(group.name() == "XY");
+        CHECK(group.size() == 2);
+        CHECK(group.get<GroupProperty>("b").get<StringProperty>("c") == StringProperty("c", "C"));
+        CHECK(group.find("c") == group.end());
+
+        auto it = group.begin();
+        CHECK(it->cast<BooleanProperty>() == BooleanProperty("a", true));
+        CHECK((++it)->displayName() == "B");
+        CHECK(++it == group.end());
+    }
+
+    SECTION("Interned subtrees")
+    {
+        const std::string limits =
+            R"JSON({"children":[{"id":"int","name":"min","value":0},{"id":"int","name":"max","value":9}],"id":"group","name":"limits"})JSON";
+        const std::string other =
+            R"JSON({"children":[{"id":"int","name":"min","value":0},{"id":"int","name":"max","value":8}],"id":"group","name":"limits"})JSON";
+        const std::string json = R"JSON({"children":[{"children":[)JSON" + limits +
+                                 R"JSON(],"id":"group","name":"a"},{"children":[)JSON" + limits +
+                                 R"JSON(],"id":"group","name":"b"},{"children":[)JSON" + other +
+                                 R"JSON(],"id":"group","name":"c"}],"id":"group","name":"channels"})JSON";
+        auto interned = serialiser.deserialise(json, JSONSerialiser::Materialisation::Interned);
+        auto eager = serialiser.deserialise(json);
+        CHECK(interned->equals(*eager));
+        CHECK(serialiser.serialise(*interned) == serialiser.serialise(*eager));
+
+        const GroupProperty& channels = interned->cast<GroupProperty>();
+        const Property& a = channels.get<GroupProperty>("a").get<Property>("limits");
+        const Property& b = channels.get<GroupProperty>("b").get<Property>("limits");
+        const GroupProperty& c = channels.get<GroupProperty>("c").get<GroupProperty>("limits");
+        CHECK(&a == &b);
+        CHECK(&a != &c);
+        // Equal leaves are shared across different subtrees too
+        CHECK(&a.cast<GroupProperty>().get<Property>("min") == &c.get<Property>("min"));
+
+        // Writing a shared instance would change all the groups sharing it
+        GroupProperty& root = interned->cast<GroupProperty>();
+        CHECK_THROWS_AS(Accessor<IntProperty>(root, "a.limits.max"), std::invalid_argument);
+        CHECK_THROWS_AS(assign(root, "a.limits.max", IntProperty("max", 7)), std::invalid_argument);
+        CHECK(channels.get<GroupProperty>("b").get<GroupProperty>("limits").get<IntProperty>("max").value() == 9);
+    }
+
+    SECTION("Shared descriptors")
+    {
+        auto prop = serialiser.deserialise(
+            R"JSON({"children":[{"children":[{"id":"int","max":9,"name":"x","value":1}],"id":"group","name":"a"},{"children":[{"id":"int","max":9,"name":"x","value":2},{"id":"int","max":8,"name":"y","value":2}],"id":"group","name":"b"}],"id":"group","name":"g"})JSON");
+        const GroupProperty& group = prop->cast<GroupProperty>();
+        const IntProperty& ax = group.get<GroupProperty>("a").get<IntProperty>("x");
+        const IntProperty& bx = group.get<GroupProperty>("b").get<IntProperty>("x");
+        CHECK(ax.descriptor() == bx.descriptor());
+        CHECK(ax.value() != bx.value());
+        CHECK(ax.descriptor() != group.get<GroupProperty>("b").get<IntProperty>("y").descriptor());
+    }
+}
+
+TEST_CASE("Interner")
+{
+    Interner interner;
+    auto first = interner.intern(std::make_unique<IntProperty>("a", 1));
+    CHECK(interner.intern(std::make_unique<IntProperty>("a", 1)) == first);
+    CHECK(interner.intern(std::make_unique<IntProperty>("a", 1, "Other")) != first);
+    CHECK(interner.intern(std::make_unique<IntProperty>("a", 2)) != first);
+    CHECK(interner.size() == 3);
+    CHECK(interner.hits() == 1);
+
+    const std::shared_ptr<const Descriptor> descriptor =
+        interner.intern(std::make_shared<const IntProperty::Descriptor>("a", 0, 9));
+    CHECK(interner.intern(std::make_shared<const IntProperty::Descriptor>("a", 0, 9)) == descriptor);
+    CHECK(interner.intern(std::make_shared<const IntProperty::Descriptor>("a", 0, 8)) != descriptor);
+    CHECK(interner.intern(std::make_shared<const DoubleProperty::Descriptor>("a", 0, 9)) != descriptor);
+    CHECK(interner.intern(std::make_shared<const Descriptor>("a")) != descriptor);
+}
+
+TEST_CASE("Shape cache")
+{
+    JSONShapeCache cache;
+
+    // Serialised document and fingerprint of a tree of the same shape
+    auto document = [](int x, double speed, const std::string& label, bool enabled) {
+        DynamicGroupProperty root("root");
+        root.insert(std::make_unique<XYProperty>("xy", IntProperty("x", x, -10, 10), IntProperty("y", 2)));
+        root.insert(std::make_unique<DoubleProperty>("speed", speed));
+        root.insert(std::make_unique<StringProperty>("label", label));
+        root.insert(std::make_unique<BooleanProperty>("enabled", enabled));
+        return std::make_pair(JSONSerialiser::shared().serialise(root, JSONSerialiser::Profile::Compact),
+                              root.fingerprint());
+    };
+
+    const auto first = document(1, 1.5, "a", true);
+    Property& tree = cache.deserialise(first.first);
+    CHECK(cache.misses() == 1);
+    CHECK(tree.fingerprint() == first.second);
+
+    SECTION("Same shape")
+    {
+        const auto second = document(-3, 2.25, "b", false);
+        CHECK(&cache.deserialise(second.first) == &tree);
+        CHECK(cache.hits() == 1);
+        CHECK(tree.fingerprint() == second.second);
+        CHECK(resolve(tree.cast<GroupProperty>(), "xy.x").cast<IntProperty>().value() == -3);
+
+        // Integers are accepted for doubles
+        std::string integral = document(-3, 4., "b", false).first;
+        integral.replace(integral.find("4.0"), 3, "4");
+        CHECK(cache.deserialise(integral).fingerprint() == document(-3, 4., "b", false).second);
+        CHECK(cache.hits() == 2);
+    }
+
+    SECTION("Other shapes")
+    {
+        // Out of bounds: the general path reports the error, the tree is unchanged
+        std::string outOfBounds = first.first;
+        outOfBounds.replace(outOfBounds.find(R"("v":1})"), 5, R"("v":11)");
+        CHECK_THROWS_AS(cache.deserialise(outOfBounds), std::out_of_range);
+        CHECK(tree.fingerprint() == first.second);
+
+        const std::string other = R"JSON({"i":"int","n":"a","v":1})JSON";
+        CHECK(cache.deserialise(other).cast<IntProperty>().value() == 1);
+        CHECK(cache.misses() == 3);
+        CHECK(cache.deserialise(R"JSON({"i":"int","n":"a","v":5})JSON").cast<IntProperty>().value() == 5);
+        CHECK(cache.hits() == 1);
+        CHECK(cache.deserialise(R"JSON({"i":"int","n":"b","v":5})JSON").name() == "b");
+        CHECK(cache.misses() == 4);
+        CHECK_THROWS(cache.deserialise("{"));
+    }
 }
 }
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <accessor.h>
+#include <diff.h>
+#include <serialisation/json_serialiser.h>
+
+namespace property
+{
+
+TEST_CASE("Fingerprint")
+{
+    XYProperty xy("xy", IntProperty("x", 1), IntProperty("y", 2));
+    XYProperty same("xy", IntProperty("x", 1), IntProperty("y", 2), "Other display");
+    XYProperty other("xy", IntProperty("x", 1), IntProperty("y", 3));
+    CHECK(xy.fingerprint() == same.fingerprint());
+    CHECK(xy.fingerprint() != other.fingerprint());
+    CHECK(xy.equals(same));
+    CHECK(!xy.equals(other));
+    CHECK(!xy.equals(IntProperty("xy", 1)));
+
+    SECTION("Updated when a child changes")
+    {
+        Accessor<IntProperty> y(xy, "y");
+        y = 3;
+        CHECK(xy.fingerprint() == other.fingerprint());
+        CHECK(xy.equals(other));
+    }
+
+    SECTION("Updated through nested groups")
+    {
+        JSONSerialiser serialiser;
+        const std::string json =
+            R"JSON({"children":[{"children":[{"id":"int","name":"max","value":7}],"id":"group","name":"limits"}],"id":"group","name":"motor"})JSON";
+        auto root = serialiser.deserialise(json);
+        auto copy = serialiser.deserialise(json);
+        const uint64_t original = root->fingerprint();
+        CHECK(copy->fingerprint() == original);
+
+        Accessor<IntProperty> max(root->cast<GroupProperty>(), "limits.max");
+        max = 8;
+        CHECK(root->fingerprint() != original);
+        max = 7;
+        CHECK(root->fingerprint() == original);
+    }
+    SECTION("Defaults for properties defining neither")
+    {
+        struct Tag : Property {
+            Tag(const std::string& name, const std::string& displayName) : Property(name, displayName) {}
+            const std::string& id() const override
+            {
+                static const std::string identifier = "tag";
+                return identifier;
+            }
+        };
+        Tag tag("tag", "A");
+        CHECK(tag.equals(Tag("tag", "A")));
+        CHECK(tag.fingerprint() == Tag("tag", "A").fingerprint());
+        CHECK(!tag.equals(Tag("tag", "B")));
+        CHECK(!tag.equals(Tag("other", "A")));
+    }
+}
+
+TEST_CASE("Diff")
+{
+    JSONSerialiser serialiser;
+    auto before = serialiser.deserialise(
+        R"JSON({"children":[{"children":[{"id":"int","name":"min","value":1},{"id":"int","name":"max","value":7}],"id":"group","name":"limits"},{"id":"string","name":"label","value":"M1"},{"id":"bool","name":"on","value":true}],"id":"group","name":"motor"})JSON");
+    auto after = serialiser.deserialise(
+        R"JSON({"children":[{"children":[{"id":"int","name":"min","value":1},{"id":"int","name":"max","value":8}],"id":"group","name":"limits"},{"id":"string","name":"label","value":"M1","display":"Label"},{"id":"double","name":"speed","value":0.5}],"id":"group","name":"motor"})JSON");
+
+    CHECK(diff(*before, *before).empty());
+
+    auto changes = diff(*before, *after);
+    REQUIRE(changes.size() == 3);
+    CHECK(changes[0].kind == Change::Kind::Modified);
+    CHECK(changes[0].path == "limits.max");
+    CHECK(changes[1].kind == Change::Kind::Added);
+    CHECK(changes[1].path == "speed");
+    CHECK(changes[2].kind == Change::Kind::Removed);
+    CHECK(changes[2].path == "on");
+
+    changes = diff(IntProperty("a", 1), DoubleProperty("a", 1));
+    REQUIRE(changes.size() == 1);
+    CHECK(changes[0].path.empty());
+}
+}
@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include "temporary_directory.h"
+#include "xyproperty.h"
+
+#include <persistence/file_store.h>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+namespace property
+{
+
+namespace
+{
+
+/// Names of the files in a directory, sorted
+std::vector<std::string> entries(const std::string& path)
+{
+    std::vector<std::string> names;
+    DIR* directory = ::opendir(path.c_str());
+    REQUIRE(directory);
+    while (const dirent* entry = ::readdir(directory)) {
+        const std::string name = entry->d_name;
+        if (name != "." && name != "..")
+            names.push_back(name);
+    }
+    ::closedir(directory);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+}
+
+TEST_CASE("File store")
+{
+    TemporaryDirectory directory;
+    const std::string path = directory.path_ + "/tree.json";
+
+    SECTION("Save and load")
+    {
+        FileStore store(path);
+        for (int i = 0; i < 100; ++i)
+            store.save(XYProperty("xy", IntProperty("x", i), IntProperty("y", -i)));
+        store.flush();
+        CHECK(XYProperty::convert(*store.load()) == XYProperty("xy", IntProperty("x", 99), IntProperty("y", -99)));
+        CHECK(entries(directory.path_) == std::vector<std::string>{"tree.json"});
+    }
+
+    SECTION("Concurrent atomic writes")
+    {
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&, t]() {
+                for (int i = 0; i < 50; ++i)
+                    writeAtomically(path, std::string(1000, static_cast<char>('a' + t)));
+            });
+        }
+        for (auto& writer : writers)
+            writer.join();
+        std::ifstream file(path);
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        REQUIRE(content.size() == 1000);
+        CHECK(content == std::string(1000, content[0]));
+        CHECK(entries(directory.path_) == std::vector<std::string>{"tree.json"});
+    }
+
+    SECTION("Pending save written on destruction")
+    {
+        {
+            FileStore store(path, JSONSerialiser::shared(), JSONSerialiser::Profile::Compact);
+            store.save(IntProperty("a", 4));
+        }
+        std::ifstream file(path);
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        CHECK(content == R"JSON({"i":"int","n":"a","v":4})JSON");
+    }
+
+    SECTION("Errors")
+    {
+        FileStore store(directory.path_ + "/missing/tree.json");
+        CHECK_THROWS_AS(store.load(), std::system_error);
+        store.save(IntProperty("a", 4));
+        CHECK_THROWS_AS(store.flush(), std::system_error);
+        CHECK_NOTHROW(store.flush());
+    }
+}
+}
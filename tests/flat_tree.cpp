@@ -0,0 +1,57 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <basic_property.h>
+#include <flat_tree.h>
+#include <serialisation/owned_group_property.h>
+
+namespace property
+{
+
+TEST_CASE("Flat tree")
+{
+    std::vector<std::unique_ptr<Property>> children;
+    children.emplace_back(new XYProperty("position", IntProperty("x", 1, -5, 5), IntProperty("y", 2)));
+    children.emplace_back(new DoubleProperty("speed", 1.5));
+    children.emplace_back(new StringProperty("label", "motor"));
+    children.emplace_back(new BooleanProperty("enabled", true));
+    OwnedGroupProperty root("root", "", std::move(children));
+
+    const FlatTree tree = flatten(root);
+    REQUIRE(tree.size() == 7);
+    CHECK(tree.paths == std::vector<std::string>{"", "position", "position.x", "position.y", "speed", "label", "enabled"});
+    CHECK(tree.kinds[0] == FlatTree::Kind::Group);
+    CHECK(tree.values[0] == 4.);
+    CHECK(tree.parents[0] == FlatTree::noParent);
+    CHECK(tree.parents[2] == 1);
+    CHECK(tree.parents[4] == 0);
+    CHECK(tree.fingerprints[1] == root.get<XYProperty>("position").fingerprint());
+
+    SECTION("Values and bounds")
+    {
+        CHECK(tree.kinds[2] == FlatTree::Kind::Int);
+        CHECK(tree.values[2] == 1.);
+        CHECK(tree.minimums[2] == -5.);
+        CHECK(tree.maximums[2] == 5.);
+        CHECK(tree.kinds[4] == FlatTree::Kind::Double);
+        CHECK(tree.values[4] == 1.5);
+        CHECK(tree.kinds[5] == FlatTree::Kind::String);
+        CHECK(tree.strings[static_cast<size_t>(tree.values[5])] == "motor");
+        CHECK(tree.kinds[6] == FlatTree::Kind::Bool);
+        CHECK(tree.values[6] == 1.);
+    }
+
+    SECTION("Linear scans")
+    {
+        double sum = 0.;
+        for (size_t i = 0; i < tree.size(); ++i) {
+            if (tree.kinds[i] == FlatTree::Kind::Int)
+                sum += tree.values[i];
+        }
+        CHECK(sum == 3.);
+        CHECK(tree.find("position.y") == 3);
+        CHECK(tree.find("missing") == tree.size());
+    }
+}
+}
@@ -2,7 +2,10 @@
 
 #include "xyproperty.h"
 
+#include <accessor.h>
+#include <dynamic_group_property.h>
 #include <group_property.h>
+#include <overlay_group_property.h>
 
 namespace property
 {
@@ -153,4 +156,124 @@ TEST_CASE("Test XYProperty")
     testGroupProperty<XYProperty, IntProperty, IntProperty>(
         IntProperty("x", 0), IntProperty("y", 1), IntProperty("x", 3), IntProperty("y", 4));
 }
+
+TEST_CASE("Test DynamicGroupProperty")
+{
+    DynamicGroupProperty group("name", "display");
+    CHECK(group.size() == 0);
+    CHECK(group.begin() == group.end());
+
+    IntProperty& a = group.insert(std::make_unique<IntProperty>("a", 1));
+    group.insert(std::make_unique<IntProperty>("c", 3));
+    group.insert(1, std::make_unique<IntProperty>("b", 2));
+    compareChildren(group.begin(), group.end(), IntProperty("a", 1), IntProperty("b", 2), IntProperty("c", 3));
+    CHECK(&group.get<IntProperty>("a") == &a);
+    CHECK_THROWS_AS(group.insert(std::make_unique<IntProperty>("a", 0)), std::invalid_argument);
+    CHECK_THROWS_AS(group.insert(4, std::make_unique<IntProperty>("d", 0)), std::out_of_range);
+
+    SECTION("Remove")
+    {
+        std::unique_ptr<Property> b = group.remove("b");
+        CHECK(b->name() == "b");
+        compareChildren(group.begin(), group.end(), IntProperty("a", 1), IntProperty("c", 3));
+        CHECK_THROWS_AS(group.remove("b"), std::out_of_range);
+    }
+
+    SECTION("Beyond the inline capacity")
+    {
+        for (size_t i = 0; i < 2 * DynamicGroupProperty::inlineCapacity; ++i)
+            group.insert(std::make_unique<IntProperty>("x" + std::to_string(i), static_cast<int>(i)));
+        group.insert(0, std::make_unique<IntProperty>("first", -1));
+        CHECK(group.size() == 2 * DynamicGroupProperty::inlineCapacity + 4);
+        CHECK(group.begin()->name() == "first");
+        CHECK(group.get<IntProperty>("x5").value() == 5);
+        CHECK(&group.get<IntProperty>("a") == &a);
+
+        group.remove("first");
+        group.remove("x0");
+        CHECK(group.begin()->name() == "a");
+        CHECK(group.get<IntProperty>("x1").value() == 1);
+        CHECK(group.find("x0") == group.end());
+
+        const std::string last = "x" + std::to_string(2 * DynamicGroupProperty::inlineCapacity - 1);
+        std::unique_ptr<Property> child = group.remove(last);
+        group.insert(group.size(), std::move(child));
+        CHECK(group.get<IntProperty>(last).value() == static_cast<int>(2 * DynamicGroupProperty::inlineCapacity - 1));
+        size_t count = 0;
+        for (const Property& child : group) {
+            CHECK(group.find(child.name())->name() == child.name());
+            ++count;
+        }
+        CHECK(count == group.size());
+    }
+
+    SECTION("Fingerprint follows the structure")
+    {
+        const uint64_t before = group.fingerprint();
+        std::unique_ptr<Property> c = group.remove("c");
+        CHECK(group.fingerprint() != before);
+        group.insert(std::move(c));
+        CHECK(group.fingerprint() == before);
+
+        Accessor<IntProperty>(group, "a") = 4;
+        CHECK(group.fingerprint() != before);
+    }
+}
+
+TEST_CASE("Test OverlayGroupProperty")
+{
+    DynamicGroupProperty defaults("config");
+    defaults.insert(std::make_unique<IntProperty>("timeout", 10));
+    defaults.insert(std::make_unique<XYProperty>("origin", IntProperty("x", 0), IntProperty("y", 0)));
+    DynamicGroupProperty& limits = defaults.insert(std::make_unique<DynamicGroupProperty>("limits"));
+    limits.insert(std::make_unique<IntProperty>("min", 0));
+    limits.insert(std::make_unique<IntProperty>("max", 100));
+
+    DynamicGroupProperty site("config", "Site config");
+    site.insert(std::make_unique<IntProperty>("retries", 3));
+    DynamicGroupProperty& siteLimits = site.insert(std::make_unique<DynamicGroupProperty>("limits"));
+    siteLimits.insert(std::make_unique<IntProperty>("max", 50));
+    site.insert(std::make_unique<IntProperty>("origin", 7));
+
+    OverlayGroupProperty overlay({&defaults, &site});
+    CHECK(overlay.name() == "config");
+    CHECK(overlay.displayName() == "Site config");
+    REQUIRE(overlay.size() == 4);
+
+    std::vector<std::string> names;
+    for (const Property& child : overlay)
+        names.push_back(child.name());
+    CHECK(names == std::vector<std::string>{"timeout", "origin", "limits", "retries"});
+
+    // Unchanged properties are those of the layers themselves
+    CHECK(&overlay.get<IntProperty>("timeout") == &defaults.get<IntProperty>("timeout"));
+    CHECK(overlay.get<IntProperty>("origin").value() == 7);
+    const GroupProperty& merged = overlay.get<GroupProperty>("limits");
+    CHECK(merged.get<IntProperty>("min").value() == 0);
+    CHECK(merged.get<IntProperty>("max").value() == 50);
+    CHECK(&merged.get<IntProperty>("max") == &siteLimits.get<IntProperty>("max"));
+    CHECK(resolve(overlay, "limits.min").cast<IntProperty>().value() == 0);
+
+    SECTION("Values follow the layers")
+    {
+        const uint64_t before = overlay.fingerprint();
+        Accessor<IntProperty>(defaults, "timeout") = 20;
+        CHECK(overlay.get<IntProperty>("timeout").value() == 20);
+        CHECK(overlay.fingerprint() != before);
+        CHECK_THROWS_AS(Accessor<IntProperty>(overlay, "limits.max"), std::invalid_argument);
+        CHECK_THROWS_AS(assign(overlay, "timeout", IntProperty("timeout", 1)), std::invalid_argument);
+        CHECK(defaults.get<IntProperty>("timeout").value() == 20);
+        Accessor<IntProperty>(siteLimits, "max") = 60;
+        CHECK(merged.get<IntProperty>("max").value() == 60);
+    }
+
+    SECTION("Refresh after structural changes")
+    {
+        site.insert(std::make_unique<IntProperty>("timeout", 5));
+        CHECK(overlay.get<IntProperty>("timeout").value() == 10);
+        overlay.refresh();
+        CHECK(overlay.get<IntProperty>("timeout").value() == 5);
+        CHECK(overlay.size() == 4);
+    }
+}
 }
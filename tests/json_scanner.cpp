@@ -0,0 +1,117 @@
+#include <catch2/catch.hpp>
+
+#include <serialisation/json_scanner.h>
+#include <serialisation/json_serialiser.h>
+
+#include <basic_property.h>
+#include <group_property.h>
+#include <numeric_property.h>
+
+using json = nlohmann::json;
+
+namespace property
+{
+
+namespace
+{
+
+std::vector<json_scanner::Isa> supportedIsas()
+{
+    std::vector<json_scanner::Isa> isas;
+    for (auto isa : {json_scanner::Isa::Portable, json_scanner::Isa::SSE42, json_scanner::Isa::AVX2}) {
+        if (json_scanner::supported(isa))
+            isas.push_back(isa);
+    }
+    return isas;
+}
+}
+
+TEST_CASE("Structural index")
+{
+    for (auto isa : supportedIsas()) {
+        json_scanner::StructuralIndex index;
+
+        const std::string text = R"({"a" : [1, true,"x\"y"], "b":-2.5e3})";
+        REQUIRE(json_scanner::index(text.data(), text.size(), index, isa));
+        CHECK(index.positions == std::vector<uint32_t>{0, 1, 3, 5, 7, 8, 9, 11, 15, 16, 21, 22, 23, 25, 27, 28, 29, 35});
+        CHECK_FALSE(index.plain);
+
+        // Strings, escapes and scalars spanning several blocks
+        std::string spanning = "[\"" + std::string(62, 'a') + "\\\\\"," + std::string(70, ' ') + "12345" +
+                               std::string(59, ' ') + "123456789, \"" + std::string(63, 'b') + "\\\"\"]";
+        REQUIRE(json_scanner::index(spanning.data(), spanning.size(), index, isa));
+        CHECK(index.positions == std::vector<uint32_t>{0, 1, 66, 67, 138, 202, 211, 213, 279, 280});
+
+        const std::string unterminated = "[\"" + std::string(100, 'a') + "\\\"]";
+        CHECK_FALSE(json_scanner::index(unterminated.data(), unterminated.size(), index, isa));
+
+        const std::string plain = R"({"name":"plain","values":[1,2,3]})";
+        REQUIRE(json_scanner::index(plain.data(), plain.size(), index, isa));
+        CHECK(index.plain);
+    }
+}
+
+TEST_CASE("Scanned parsing")
+{
+    std::string large = "[";
+    for (int i = 0; i < 1000; ++i)
+        large += R"({"id":"double","name":"channel)" + std::to_string(i) + R"(","value":)" + std::to_string(i * 0.25) +
+                 R"(,"min":-1e3,"max":18446744073709551615,"flag":false,"none":null},)";
+    large += R"("caf\u00e9 \ud83d\ude00","café",[],{},0,-0,12345678901234567890,-9223372036854775808])";
+
+    const std::vector<std::string> valid{
+        "0",
+        " \t\n\"text\" ",
+        "[1,2.5,-3,4e2,5E-1,true,false,null]",
+        R"({"a":{"b":{"c":[[],[[]]]}},"a":"last"})",
+        R"(["tab\tquote\"slash\/backslash\\"])",
+        std::string(600, '[') + std::string(600, ']'),
+        large,
+    };
+    const std::vector<std::string> invalid{
+        "",
+        "   ",
+        "[1,]",
+        "{\"a\" 1}",
+        "{\"a\":1,}",
+        "[01]",
+        "[1.]",
+        "[.5]",
+        "[1e]",
+        "[tru]",
+        "[1 2]",
+        "[\"open]",
+        "[\"a\tb\"]",
+        "[\"\\x\"]",
+        "[\"\xff\"]",
+        "[1e400]",
+        "{} {}",
+        "[1]]",
+    };
+
+    for (auto isa : supportedIsas()) {
+        for (const std::string& text : valid) {
+            const json expected = json::parse(text);
+            const json parsed = json_scanner::parse(text.data(), text.size(), isa);
+            CHECK(parsed == expected);
+            CHECK(parsed.dump() == expected.dump());
+        }
+        for (const std::string& text : invalid)
+            CHECK_THROWS_AS(json_scanner::parse(text.data(), text.size(), isa), json::exception);
+    }
+
+    SECTION("Deserialisation")
+    {
+        const std::string text =
+            R"({"children":[{"id":"int","max":10,"min":-10,"name":"x","value":-3},{"id":"double","name":"y","value":0.5},)"
+            R"({"id":"string","name":"s","value":"\u00e9t\u00e9"},{"id":"bool","name":"b","value":true}],"id":"group","name":"g"})";
+        auto prop = JSONSerialiser::shared().deserialise(text);
+        const GroupProperty& group = prop->cast<GroupProperty>();
+        CHECK(group.get<IntProperty>("x").value() == -3);
+        CHECK(group.get<IntProperty>("x").min() == -10);
+        CHECK(group.get<DoubleProperty>("y").value() == 0.5);
+        CHECK(group.get<StringProperty>("s").value() == "\xc3\xa9t\xc3\xa9");
+        CHECK(group.get<BooleanProperty>("b").value());
+    }
+}
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <serialisation/ndjson_stream.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <system_error>
+
+namespace property
+{
+
+namespace
+{
+
+std::string snapshots(size_t count)
+{
+    std::ostringstream out;
+    NDJSONWriter writer(out);
+    for (size_t i = 0; i < count; ++i)
+        writer.write(XYProperty("xy" + std::to_string(i), IntProperty("x", i), IntProperty("y", -i)));
+    return out.str();
+}
+
+template <class Reader>
+void checkSnapshots(Reader& reader, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        auto prop = reader.next();
+        REQUIRE(prop);
+        CHECK(XYProperty::convert(*prop) ==
+              XYProperty("xy" + std::to_string(i), IntProperty("x", i), IntProperty("y", -i)));
+    }
+    CHECK(!reader.next());
+}
+}
+
+TEST_CASE("NDJSON")
+{
+    SECTION("Writer")
+    {
+        std::ostringstream out;
+        NDJSONWriter writer(out, JSONSerialiser::shared(), JSONSerialiser::Profile::Compact);
+        writer.write(IntProperty("a", 1));
+        writer.write(BooleanProperty("b", true));
+        CHECK(out.str() == "{\"i\":\"int\",\"n\":\"a\",\"v\":1}\n{\"i\":\"bool\",\"n\":\"b\",\"v\":true}\n");
+    }
+
+    SECTION("Reader")
+    {
+        std::istringstream in(snapshots(20) + "\n  \n");
+        NDJSONReader reader(in);
+        checkSnapshots(reader, 20);
+    }
+
+    SECTION("Line too long")
+    {
+        std::istringstream in(snapshots(1));
+        NDJSONReader reader(in, JSONSerialiser::shared(), 16);
+        CHECK_THROWS_AS(reader.next(), std::length_error);
+    }
+
+    SECTION("Pipeline")
+    {
+        std::istringstream in(snapshots(500));
+        NDJSONPipeline pipeline(in, JSONSerialiser::shared(), 3, 8);
+        checkSnapshots(pipeline, 500);
+    }
+
+    SECTION("Pipeline errors in order")
+    {
+        std::istringstream in(snapshots(2) + "{not json\n" + snapshots(1));
+        NDJSONPipeline pipeline(in, JSONSerialiser::shared(), 2, 2);
+        CHECK(pipeline.next());
+        CHECK(pipeline.next());
+        CHECK_THROWS(pipeline.next());
+        CHECK(pipeline.next());
+        CHECK(!pipeline.next());
+    }
+
+    SECTION("Pipeline stopped early")
+    {
+        std::istringstream in(snapshots(100));
+        NDJSONPipeline pipeline(in, JSONSerialiser::shared(), 2, 4);
+        CHECK(pipeline.next());
+    }
+
+    SECTION("File descriptor")
+    {
+        int fds[2];
+        REQUIRE(::pipe(fds) == 0);
+        {
+            FileDescriptorBuffer buffer(fds[1]);
+            std::ostream out(&buffer);
+            NDJSONWriter writer(out);
+            writer.write(IntProperty("a", 1));
+        }
+        ::close(fds[1]);
+        FileDescriptorBuffer buffer(fds[0]);
+        std::istream in(&buffer);
+        NDJSONReader reader(in);
+        auto prop = reader.next();
+        REQUIRE(prop);
+        CHECK(IntProperty::convert(*prop) == IntProperty("a", 1));
+        CHECK(!reader.next());
+        ::close(fds[0]);
+    }
+
+    SECTION("Read error")
+    {
+        // Directories cannot be read
+        const int fd = ::open(".", O_RDONLY | O_DIRECTORY);
+        REQUIRE(fd >= 0);
+        FileDescriptorBuffer buffer(fd);
+        std::istream in(&buffer);
+        NDJSONReader reader(in);
+        CHECK_THROWS_AS(reader.next(), std::system_error);
+        ::close(fd);
+    }
+
+    SECTION("Pipeline stopped while the reader waits")
+    {
+        int fds[2];
+        REQUIRE(::pipe(fds) == 0);
+        REQUIRE(::write(fds[1], "{\"id\":\"int\",\"name\":\"a\",\"value\":1}\n", 34) == 34);
+        FileDescriptorBuffer buffer(fds[0]);
+        std::istream in(&buffer);
+        {
+            NDJSONPipeline pipeline(in);
+            CHECK(pipeline.next());
+            // Nothing more is written and the pipe stays open: the destructor must not wait for it
+        }
+        REQUIRE(::write(fds[1], "{\"id\":\"int\",\"name\":\"b\",\"value\":2}\n", 34) == 34);
+        ::close(fds[1]);
+        in.clear();
+        NDJSONReader reader(in);
+        auto prop = reader.next();
+        REQUIRE(prop);
+        CHECK(prop->name() == "b");
+        ::close(fds[0]);
+    }
+}
+}
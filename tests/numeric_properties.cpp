@@ -163,6 +163,27 @@ void testNumericPropertyUnequality(const typename T::value_type& min, const type
     CHECK(base != T("name", min, min, max + 1, "display"));
 }
 
+template <class T>
+void testNumericPropertyDescriptor(const typename T::value_type& min, const typename T::value_type& max)
+{
+    INFO("NumericProperty instances share their descriptor");
+    auto descriptor = std::make_shared<const typename T::Descriptor>("name", min, max, "display");
+    T prop(descriptor, max);
+    checkNumericProperty(prop, max, min, max);
+    CHECK(prop.descriptor() == descriptor);
+    CHECK(T(prop).descriptor() == descriptor);
+    CHECK(T("name", prop).descriptor() == descriptor);
+    CHECK(T("name2", prop).descriptor() != descriptor);
+    CHECK(prop == T("name", max, min, max, "display"));
+    CHECK_THROWS_AS(T(descriptor, max + typename T::value_type(1)), std::out_of_range);
+
+    T other("name", min);
+    prop = other;
+    CHECK(prop.min() == other.min());
+    CHECK(prop.displayName() == "display");
+    CHECK(descriptor->min() == min);
+}
+
 template <class T>
 void testNumericProperty(const typename T::value_type& min, const typename T::value_type& max)
 {
@@ -172,6 +193,7 @@ void testNumericProperty(const typename T::value_type& min, const typename T::va
         testNumericPropertyCopyConstructor<T>(min, max);
         testNumericPropertyCopyOperator<T>(min, max);
         testNumericPropertyConvert<T>(min, max);
+        testNumericPropertyDescriptor<T>(min, max);
     }
 
     {
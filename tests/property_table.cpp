@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <accessor.h>
+#include <basic_property.h>
+#include <property_table.h>
+#include <serialisation/json_serialiser.h>
+#include <serialisation/owned_group_property.h>
+
+namespace property
+{
+
+TEST_CASE("Property table")
+{
+    PropertyTable table(XYProperty("xy", IntProperty("x", 0, -10, 10), IntProperty("y", 0), "Point"));
+    REQUIRE(table.columns() == 2);
+    CHECK(table.column("y") == 1);
+    CHECK_THROWS_AS(table.column("z"), std::out_of_range);
+    CHECK(table.kind(0) == PropertyTable::Kind::Int);
+
+    table.append(XYProperty("xy", IntProperty("x", 1), IntProperty("y", 2)));
+    table.append(XYProperty("xy", IntProperty("x", 3), IntProperty("y", 4)));
+    table.append();
+    REQUIRE(table.size() == 3);
+    CHECK_THROWS_AS(table.append(XYProperty("xy", IntProperty("x", 11), IntProperty("y", 0))), std::out_of_range);
+    CHECK(table.size() == 3);
+
+    SECTION("Rows as groups")
+    {
+        PropertyTable::Row row = table.row(1);
+        CHECK(row.name() == "xy");
+        CHECK(row.displayName() == "Point");
+        CHECK(row.equals(XYProperty("xy", IntProperty("x", 3, -10, 10), IntProperty("y", 4))));
+        CHECK(XYProperty::convert(row) == XYProperty("xy", IntProperty("x", 3, -10, 10), IntProperty("y", 4)));
+        CHECK_THROWS_AS(table.row(3), std::out_of_range);
+
+        Accessor<IntProperty> x(row, "x");
+        x = 7;
+        CHECK(table.integers(0)[1] == 7);
+        CHECK(table.row(1).get<IntProperty>("x").value() == 7);
+        CHECK_THROWS_AS(x = 11, std::out_of_range);
+        CHECK(table.integers(0)[1] == 7);
+
+        // Only the changed column is written back
+        table.integers(1)[1] = 9;
+        x = 8;
+        CHECK(table.integers(0)[1] == 8);
+        CHECK(table.integers(1)[1] == 9);
+
+        // A property with wider bounds is refused by the column, and the row keeps the value of the column
+        CHECK_THROWS_AS(assign(row, "x", IntProperty("x", 20, 0, 100)), std::out_of_range);
+        CHECK(table.integers(0)[1] == 8);
+        CHECK(row.get<IntProperty>("x") == IntProperty("x", 8, -10, 10));
+
+        const PropertyTable& constTable = table;
+        PropertyTable::Row constRow = constTable.row(1);
+        CHECK_FALSE(constRow.writable());
+        CHECK_THROWS_AS(Accessor<IntProperty>(constRow, "x"), std::invalid_argument);
+    }
+
+    SECTION("Column operations")
+    {
+        int* x = table.integers(0);
+        for (size_t i = 0; i < table.size(); ++i)
+            x[i] *= 5;
+        CHECK(x[1] == 15);
+        table.clamp(0);
+        CHECK(x[1] == 10);
+        CHECK(x[0] == 5);
+        CHECK_THROWS_AS(table.reals(0), std::bad_cast);
+    }
+
+    SECTION("Mixed fields")
+    {
+        std::vector<std::unique_ptr<Property>> fields;
+        fields.emplace_back(new StringProperty("label", "none"));
+        fields.emplace_back(new BooleanProperty("enabled", false));
+        fields.emplace_back(new DoubleProperty("speed", 0., 0., 100.));
+        PropertyTable mixed(OwnedGroupProperty("motor", "", std::move(fields)));
+        mixed.append();
+        mixed.strings(0)[0] = "left";
+        mixed.booleans(1)[0] = true;
+        mixed.reals(2)[0] = 1.5;
+        const PropertyTable& constant = mixed;
+        CHECK(constant.row(0).get<StringProperty>("label").value() == "left");
+        CHECK(constant.row(0).get<BooleanProperty>("enabled").value());
+        CHECK(constant.row(0).get<DoubleProperty>("speed").value() == 1.5);
+
+        std::vector<std::unique_ptr<Property>> nested;
+        nested.emplace_back(new XYProperty("xy", IntProperty("x", 0), IntProperty("y", 0)));
+        CHECK_THROWS_AS(PropertyTable(OwnedGroupProperty("nested", "", std::move(nested))), std::invalid_argument);
+    }
+
+    SECTION("Bulk serialisation")
+    {
+        const JSONSerialiser& serialiser = JSONSerialiser::shared();
+        std::string json;
+        serialiser.serialise(table, json, JSONSerialiser::Profile::Compact);
+        CHECK(json == R"JSON({"a":[[1,3,0],[2,4,0]],"d":"Point","n":"xy","s":[{"h":10,"i":"int","l":-10,"n":"x","v":0},{"i":"int","n":"y","v":0}]})JSON");
+
+        for (auto profile : {JSONSerialiser::Profile::Verbose, JSONSerialiser::Profile::Compact}) {
+            serialiser.serialise(table, json, profile);
+            PropertyTable read = serialiser.deserialiseTable(json);
+            REQUIRE(read.size() == 3);
+            CHECK(read.displayName() == "Point");
+            CHECK(read.schema(0).equals(table.schema(0)));
+            CHECK(read.row(1).equals(table.row(1)));
+            CHECK(read.integers(1)[0] == 2);
+        }
+
+        // Out of bounds values are rejected, not clamped
+        serialiser.serialise(table, json);
+        const std::string outOfBounds = std::string(json).replace(json.find("[[1,"), 4, "[[11,");
+        CHECK_THROWS_AS(serialiser.deserialiseTable(outOfBounds), std::out_of_range);
+    }
+}
+}
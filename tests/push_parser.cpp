@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <serialisation/json_push_parser.h>
+#include <serialisation/owned_group_property.h>
+
+namespace property
+{
+
+namespace
+{
+
+std::unique_ptr<Property> tree()
+{
+    std::vector<std::unique_ptr<Property>> limits;
+    limits.push_back(std::make_unique<DoubleProperty>("min", -1.5, -10., 10.));
+    limits.push_back(std::make_unique<DoubleProperty>("max", 2.25e10));
+    std::vector<std::unique_ptr<Property>> children;
+    children.push_back(std::make_unique<OwnedGroupProperty>("limits", "Limits", std::move(limits)));
+    children.push_back(std::make_unique<StringProperty>("label", "Motor \"A\" \xc3\xa9t\xc3\xa9", "Label"));
+    children.push_back(std::make_unique<BooleanProperty>("enabled", true));
+    children.push_back(std::make_unique<IntProperty>("steps", -12345, -20000, 20000));
+    children.push_back(std::make_unique<OwnedGroupProperty>("empty", "", std::vector<std::unique_ptr<Property>>{}));
+    return std::make_unique<OwnedGroupProperty>("motor", "", std::move(children));
+}
+}
+
+TEST_CASE("Push parser")
+{
+    const JSONSerialiser& serialiser = JSONSerialiser::shared();
+    auto motor = tree();
+    const std::string verbose = serialiser.serialise(*motor);
+    const std::string compact = serialiser.serialise(*motor, JSONSerialiser::Profile::Compact);
+    const std::string xy =
+        serialiser.serialise(XYProperty("xy", IntProperty("x", 1), IntProperty("y", 2)), JSONSerialiser::Profile::Compact);
+    const std::string input = verbose + "\n" + compact + " \r\n\t" + xy + xy;
+
+    SECTION("Chunks of any size")
+    {
+        for (size_t chunk = 1; chunk <= 64; ++chunk) {
+            JSONPushParser parser;
+            size_t completed = 0;
+            for (size_t offset = 0; offset < input.size(); offset += chunk)
+                completed += parser.feed(input.data() + offset, std::min(chunk, input.size() - offset));
+            CHECK(completed == 4);
+            CHECK_FALSE(parser.pending());
+            for (int i = 0; i < 2; ++i) {
+                auto prop = parser.next();
+                REQUIRE(prop);
+                CHECK(prop->equals(*motor));
+                CHECK(serialiser.serialise(*prop) == verbose);
+            }
+            for (int i = 0; i < 2; ++i) {
+                auto prop = parser.next();
+                REQUIRE(prop);
+                CHECK(serialiser.serialise(*prop, JSONSerialiser::Profile::Compact) == xy);
+            }
+            CHECK(!parser.next());
+        }
+    }
+
+    SECTION("Documents returned as soon as complete")
+    {
+        JSONPushParser parser;
+        CHECK(parser.feed(verbose.substr(0, verbose.size() - 1)) == 0);
+        CHECK(parser.pending());
+        CHECK(!parser.next());
+        CHECK(parser.feed("}{") == 1);
+        CHECK(parser.pending());
+        CHECK(parser.next()->equals(*motor));
+    }
+
+    SECTION("Errors")
+    {
+        JSONPushParser parser(serialiser, 32);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"int","name":"a","value":[1]})"), std::invalid_argument);
+        CHECK_FALSE(parser.pending());
+        CHECK_THROWS_AS(parser.feed(R"({"id":"int","name":"a","value":1,})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"int","name":"a","value":01})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"int","children":[],"name":"a"})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"string","name":"a","value":"\x"})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"([{"id":"int","name":"a","value":1}])"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"string","name":"a","value":")" + std::string(40, 'a')),
+                        std::length_error);
+
+        // Valid JSON, but not a property
+        CHECK_THROWS_AS(parser.feed(R"({"id":"int","name":"a","value":"x"})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"int","name":"a"})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"group","name":"a"})"), std::invalid_argument);
+        CHECK_THROWS_AS(parser.feed(R"({"id":"nope","name":"a","value":1})"), std::invalid_argument);
+        CHECK_FALSE(parser.pending());
+
+        // Numbers too long for the scanner to convert, out of range
+        JSONPushParser unbounded(serialiser);
+        CHECK_THROWS_AS(unbounded.feed(R"({"i":"double","n":"a","v":1)" + std::string(70, '0') + "e999}"),
+                        std::invalid_argument);
+
+        // Parsing resumes with the next document
+        CHECK(parser.feed(R"({"i":"int","n":"a","v":1})") == 1);
+        CHECK(parser.next()->equals(IntProperty("a", 1)));
+    }
+}
+}
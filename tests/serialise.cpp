@@ -1,10 +1,15 @@
 #include <catch2/catch.hpp>
 
+#include <accessor.h>
+#include <dynamic_group_property.h>
+#include <overlay_group_property.h>
 #include <serialisation/json_serialiser.h>
 
 #include "bool2property.h"
 #include "xyproperty.h"
 
+#include <thread>
+
 namespace property
 {
 
@@ -79,5 +84,171 @@ TEST_CASE("Serialise to JSON")
             serialiser.serialise(XYProperty("XY", IntProperty("a", 3), IntProperty("b", 1, -3, 9, "MyB"))) ==
             R"JSON({"children":[{"display":"a","id":"int","name":"a","value":3},{"display":"MyB","id":"int","max":9,"min":-3,"name":"b","value":1}],"display":"XY","id":"group","name":"XY"})JSON");
     }
+
+    SECTION("Compact")
+    {
+        CHECK(serialiser.serialise(StringProperty("name", "Value"), JSONSerialiser::Profile::Compact) ==
+              R"JSON({"i":"string","n":"name","v":"Value"})JSON");
+        CHECK(
+            serialiser.serialise(XYProperty("XY", IntProperty("a", 3), IntProperty("b", 1, -3, 9, "MyB")),
+                                 JSONSerialiser::Profile::Compact) ==
+            R"JSON({"c":[{"i":"int","n":"a","v":3},{"d":"MyB","h":9,"i":"int","l":-3,"n":"b","v":1}],"i":"group","n":"XY"})JSON");
+    }
+
+    SECTION("Positional")
+    {
+        CHECK(serialiser.serialise(XYProperty("XY", IntProperty("a", 3), IntProperty("b", 1, -3, 9, "MyB")),
+                                   JSONSerialiser::Profile::Positional) ==
+              R"JSON({"c":[{"i":"int","v":3},{"d":"MyB","h":9,"i":"int","l":-3,"v":1}],"i":"group","n":"XY"})JSON");
+    }
+}
+
+TEST_CASE("Memoised serialisation")
+{
+    const JSONSerialiser& serialiser = JSONSerialiser::shared();
+    const auto memoised = JSONSerialiser::Memoisation::On;
+    DynamicGroupProperty root("root");
+    DynamicGroupProperty& channels = root.insert(std::make_unique<DynamicGroupProperty>("channels"));
+    for (int i = 0; i < 3; ++i) {
+        channels.insert(std::make_unique<XYProperty>(
+            "c" + std::to_string(i), IntProperty("x", i), IntProperty("y", -i, -5, 5, "Y")));
+    }
+    root.insert(std::make_unique<StringProperty>("label", "L"));
+
+    for (auto profile :
+         {JSONSerialiser::Profile::Verbose, JSONSerialiser::Profile::Compact, JSONSerialiser::Profile::Positional}) {
+        INFO(static_cast<int>(profile));
+        CHECK(serialiser.serialise(root, profile, memoised) == serialiser.serialise(root, profile));
+        CHECK(serialiser.serialise(root, profile, memoised) == serialiser.serialise(root, profile));
+    }
+
+    SECTION("Changed leaf")
+    {
+        Accessor<IntProperty>(root, "channels.c1.y") = 4;
+        CHECK(serialiser.serialise(root, JSONSerialiser::Profile::Positional, memoised) ==
+              serialiser.serialise(root, JSONSerialiser::Profile::Positional));
+        Accessor<StringProperty>(root, "label") = "M";
+        const std::string out = serialiser.serialise(root, JSONSerialiser::Profile::Positional, memoised);
+        CHECK(out == serialiser.serialise(root, JSONSerialiser::Profile::Positional));
+        CHECK(out.find(R"("v":"M")") != std::string::npos);
+    }
+
+    SECTION("Changed structure")
+    {
+        channels.remove("c0");
+        CHECK(serialiser.serialise(root, JSONSerialiser::Profile::Compact, memoised) ==
+              serialiser.serialise(root, JSONSerialiser::Profile::Compact));
+    }
+}
+
+TEST_CASE("Memoised serialisation of an overlay")
+{
+    const JSONSerialiser& serialiser = JSONSerialiser::shared();
+    const auto memoised = JSONSerialiser::Memoisation::On;
+    DynamicGroupProperty defaults("limits");
+    defaults.insert(std::make_unique<IntProperty>("min", 0));
+    defaults.insert(std::make_unique<IntProperty>("max", 100));
+    DynamicGroupProperty site("limits");
+    site.insert(std::make_unique<IntProperty>("max", 50));
+
+    DynamicGroupProperty root("root");
+    DynamicGroupProperty& config = root.insert(std::make_unique<DynamicGroupProperty>("config"));
+    config.insert(std::make_unique<OverlayGroupProperty>(std::vector<const GroupProperty*>{&defaults, &site}));
+    root.insert(std::make_unique<StringProperty>("label", "L"));
+
+    const uint64_t before = root.fingerprint();
+    CHECK(serialiser.serialise(root, JSONSerialiser::Profile::Compact, memoised) ==
+          serialiser.serialise(root, JSONSerialiser::Profile::Compact));
+
+    // The leaf only tells its layer, which the overlay does not enclose
+    Accessor<IntProperty>(site, "max") = 60;
+    CHECK(root.fingerprint() != before);
+    const std::string out = serialiser.serialise(root, JSONSerialiser::Profile::Compact, memoised);
+    CHECK(out == serialiser.serialise(root, JSONSerialiser::Profile::Compact));
+    CHECK(out.find("60") != std::string::npos);
+}
+
+TEST_CASE("Serialisation plan")
+{
+    const JSONSerialiser& serialiser = JSONSerialiser::shared();
+    DynamicGroupProperty root("root", "The \"root\"");
+    root.insert(std::make_unique<XYProperty>("xy", IntProperty("x", 1), IntProperty("y", -1, -5, 5, "Y")));
+    root.insert(std::make_unique<Bool2Property>("flags", BooleanProperty("a", true), BooleanProperty("b", false)));
+    root.insert(std::make_unique<DoubleProperty>("speed", 1.5, 0., 10.));
+    root.insert(std::make_unique<StringProperty>("label", "a\nb"));
+    root.insert(std::make_unique<DynamicGroupProperty>("empty"));
+
+    for (auto profile :
+         {JSONSerialiser::Profile::Verbose, JSONSerialiser::Profile::Compact, JSONSerialiser::Profile::Positional}) {
+        INFO(static_cast<int>(profile));
+        const JSONSerialiser::Plan plan = serialiser.compile(root, profile);
+        std::string out;
+        plan.execute(out);
+        CHECK(out == serialiser.serialise(root, profile));
+
+        Accessor<IntProperty>(root, "xy.y") = 4;
+        Accessor<DoubleProperty>(root, "speed") = 2.25;
+        Accessor<StringProperty>(root, "label") = "c";
+        Accessor<BooleanProperty>(root, "flags.b") = true;
+        plan.execute(out);
+        CHECK(out == serialiser.serialise(root, profile));
+
+        // Bounds are values too
+        const_cast<IntProperty&>(resolve(root, "xy.x").cast<IntProperty>()) = IntProperty("x", 0, -2, 2);
+        plan.execute(out);
+        CHECK(out == serialiser.serialise(root, profile));
+    }
+}
+
+TEST_CASE("Serialise escaped strings")
+{
+    CHECK(JSONSerialiser::shared().serialise(StringProperty("s", "a\"b\\c\n\x01")) ==
+          R"JSON({"display":"s","id":"string","name":"s","value":"a\"b\\c\n\u0001"})JSON");
+    CHECK(JSONSerialiser::shared().serialise(StringProperty("s", "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80")) ==
+          "{\"display\":\"s\",\"id\":\"string\",\"name\":\"s\",\"value\":\"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\"}");
+    for (const char* invalid : {"\xC3", "\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "a\xFF"})
+        CHECK_THROWS_AS(JSONSerialiser::shared().serialise(StringProperty("s", invalid)), std::invalid_argument);
+}
+
+TEST_CASE("Serialise reals")
+{
+    // As nlohmann::json::dump writes them
+    const std::vector<std::pair<double, std::string>> expected{{1.5, "1.5"},
+                                                                {100., "100.0"},
+                                                                {0.1, "0.1"},
+                                                                {1e15, "1e+15"},
+                                                                {123456789012345., "123456789012345.0"},
+                                                                {1e-4, "0.0001"},
+                                                                {1e-5, "1e-05"},
+                                                                {-2.5e-300, "-2.5e-300"},
+                                                                {1. / 3, "0.3333333333333333"}};
+    for (const auto& real : expected) {
+        const std::string out = JSONSerialiser::shared().serialise(DoubleProperty("r", real.first));
+        CHECK(out.substr(out.find(R"("value":)") + 8) == real.second + "}");
+    }
+}
+
+TEST_CASE("Shared serialiser")
+{
+    const JSONSerialiser& serialiser = JSONSerialiser::shared();
+    const XYProperty xy("XY", IntProperty("a", 3), IntProperty("b", 1, -3, 9, "MyB"));
+    const std::string expected = serialiser.serialise(xy);
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (size_t t = 0; t < failures.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            std::string out;
+            for (int i = 0; i < 1000; ++i) {
+                serialiser.serialise(xy, out);
+                auto read = serialiser.deserialise(out);
+                if (out != expected || serialiser.serialise(*read) != expected)
+                    ++failures[t];
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    CHECK(failures == std::vector<int>(failures.size(), 0));
 }
 }
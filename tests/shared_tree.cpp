@@ -0,0 +1,134 @@
+#include <catch2/catch.hpp>
+
+#include "xyproperty.h"
+
+#include <accessor.h>
+#include <persistence/shared_tree.h>
+#include <serialisation/json_serialiser.h>
+#include <serialisation/owned_group_property.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+namespace property
+{
+
+namespace
+{
+
+std::unique_ptr<GroupProperty> motor(const std::string& speedDisplay = "Speed", double maxSpeed = 10.)
+{
+    std::vector<std::unique_ptr<Property>> children;
+    children.push_back(std::make_unique<XYProperty>("position", IntProperty("x", 1), IntProperty("y", -1)));
+    children.push_back(std::make_unique<DoubleProperty>("speed", 0.5, 0., maxSpeed, speedDisplay));
+    children.push_back(std::make_unique<StringProperty>("label", "Motor"));
+    children.push_back(std::make_unique<BooleanProperty>("enabled", true));
+    return std::make_unique<OwnedGroupProperty>("motor", "Motor", std::move(children));
+}
+}
+
+TEST_CASE("Shared tree")
+{
+    const std::string name = "/properties-test-" + std::to_string(::getpid());
+    auto tree = motor();
+    SharedTreePublisher publisher(name, *tree, 8);
+    CHECK(publisher.version() == 1);
+
+    SharedTreeReader reader(name);
+    CHECK(reader.version() == 1);
+    CHECK(reader.tree().equals(*tree));
+    CHECK(JSONSerialiser::shared().serialise(reader.tree()) == JSONSerialiser::shared().serialise(*tree));
+    CHECK_FALSE(reader.refresh());
+
+    SECTION("Changed values")
+    {
+        const GroupProperty& view = reader.tree().cast<GroupProperty>();
+        const Property* position = &view.get<Property>("position");
+        const uint64_t fingerprint = position->fingerprint();
+
+        Accessor<DoubleProperty>(*tree, "speed") = 2.5;
+        Accessor<StringProperty>(*tree, "label") = "Motor 1";
+        publisher.publish(*tree);
+        CHECK(reader.refresh());
+        CHECK(reader.version() == 2);
+        CHECK(reader.tree().equals(*tree));
+        CHECK(&view.get<Property>("position") == position);
+        CHECK(position->fingerprint() == fingerprint);
+        CHECK(reader.tree().fingerprint() == tree->fingerprint());
+
+        Accessor<StringProperty>(*tree, "label") = "Much too long";
+        CHECK_THROWS_AS(publisher.publish(*tree), std::length_error);
+        Accessor<StringProperty>(*tree, "label") = "";
+        publisher.publish(*tree);
+        CHECK(reader.refresh());
+        CHECK(view.get<StringProperty>("label").value().empty());
+    }
+
+    SECTION("Shape checked")
+    {
+        CHECK_THROWS_AS(publisher.publish(IntProperty("motor", 1)), std::invalid_argument);
+        std::vector<std::unique_ptr<Property>> children;
+        children.push_back(std::make_unique<IntProperty>("speed", 1));
+        CHECK_THROWS_AS(publisher.publish(OwnedGroupProperty("motor", "", std::move(children))), std::invalid_argument);
+
+        // Display names and bounds are part of the shape, the readers having built their views with them
+        CHECK_THROWS_AS(publisher.publish(*motor("Other")), std::invalid_argument);
+        CHECK_THROWS_AS(publisher.publish(*motor("Speed", 20.)), std::invalid_argument);
+        CHECK(publisher.version() == 1);
+    }
+
+    SECTION("Consistent snapshots")
+    {
+        std::atomic<bool> done{false};
+        std::thread writer([&]() {
+            for (int i = 0; i < 20000; ++i) {
+                Accessor<IntProperty>(*tree, "position.x") = i;
+                Accessor<IntProperty>(*tree, "position.y") = -i;
+                publisher.publish(*tree);
+            }
+            done = true;
+        });
+        const GroupProperty& position = reader.tree().cast<GroupProperty>().get<GroupProperty>("position");
+        while (!done) {
+            reader.refresh();
+            CHECK(position.get<IntProperty>("x").value() == -position.get<IntProperty>("y").value());
+        }
+        writer.join();
+        reader.refresh();
+        CHECK(position.get<IntProperty>("x").value() == 19999);
+    }
+
+    SECTION("Retired")
+    {
+        CHECK_FALSE(reader.retired());
+        {
+            SharedTreePublisher replacement(name, IntProperty("other", 1));
+            CHECK(reader.retired());
+            SharedTreeReader other(name);
+            CHECK(other.tree().equals(IntProperty("other", 1)));
+            CHECK_FALSE(other.retired());
+
+            // A replaced publisher leaves the name to its replacement
+            auto first = std::make_unique<SharedTreePublisher>(name, IntProperty("first", 1));
+            CHECK(other.retired());
+            SharedTreePublisher second(name, IntProperty("second", 2));
+            first.reset();
+            CHECK(SharedTreeReader(name).tree().equals(IntProperty("second", 2)));
+        }
+        CHECK_THROWS_AS(SharedTreeReader(name), std::system_error);
+        CHECK_THROWS_AS(SharedTreeReader("/properties-test-missing"), std::system_error);
+    }
+
+    SECTION("Publisher gone")
+    {
+        auto gone = std::make_unique<SharedTreePublisher>(name + "-gone", *tree);
+        SharedTreeReader orphan(name + "-gone");
+        CHECK_FALSE(orphan.retired());
+        gone.reset();
+        CHECK(orphan.retired());
+        CHECK(orphan.tree().equals(*tree));
+    }
+}
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include "temporary_directory.h"
+
+#include <persistence/file_store.h>
+#include <persistence/startup_cache.h>
+
+#include <fstream>
+
+namespace property
+{
+
+TEST_CASE("Startup cache")
+{
+    TemporaryDirectory directory;
+    const std::string image = directory.path_ + "/config.image";
+    const std::string json =
+        R"JSON({"children":[{"id":"int","max":10,"name":"x","value":1},{"id":"string","name":"s","value":"S"}],"id":"group","name":"config"})JSON";
+    const std::string changed =
+        R"JSON({"children":[{"id":"int","max":10,"name":"x","value":2},{"id":"string","name":"s","value":"S"}],"id":"group","name":"config"})JSON";
+
+    StartupCache cache(image);
+    auto parsed = cache.load(json);
+    CHECK(cache.misses() == 1);
+
+    SECTION("Unchanged source")
+    {
+        auto cached = cache.load(json);
+        CHECK(cache.hits() == 1);
+        CHECK(cached->equals(*parsed));
+        CHECK(JSONSerialiser::shared().serialise(*cached) == JSONSerialiser::shared().serialise(*parsed));
+
+        // Another process starting with the same document
+        StartupCache next(image);
+        CHECK(next.load(json)->equals(*parsed));
+        CHECK(next.hits() == 1);
+    }
+
+    SECTION("Changed source")
+    {
+        auto reparsed = cache.load(changed);
+        CHECK(cache.misses() == 2);
+        CHECK(!reparsed->equals(*parsed));
+        CHECK(cache.load(changed)->equals(*reparsed));
+        CHECK(cache.hits() == 1);
+    }
+
+    SECTION("Damaged image")
+    {
+        MappedFile mapped(image);
+        const std::string content(mapped.data(), mapped.size());
+        writeAtomically(image, content.substr(0, content.size() - 3));
+        CHECK(cache.load(json)->equals(*parsed));
+        CHECK(cache.misses() == 2);
+        CHECK(cache.load(json)->equals(*parsed));
+        CHECK(cache.hits() == 1);
+
+        std::string flipped = content;
+        flipped[4] = 9;
+        writeAtomically(image, flipped);
+        CHECK(cache.load(json)->equals(*parsed));
+        CHECK(cache.misses() == 3);
+    }
+
+    SECTION("Damaged body")
+    {
+        MappedFile mapped(image);
+        const std::string content(mapped.data(), mapped.size());
+        // Header consistent with a truncated body
+        std::string truncated = content.substr(0, content.size() - 3);
+        const uint64_t treeSize = content.size() - 3 - 32;
+        truncated.replace(24, sizeof(treeSize), reinterpret_cast<const char*>(&treeSize), sizeof(treeSize));
+        writeAtomically(image, truncated);
+        CHECK(cache.load(json)->equals(*parsed));
+        CHECK(cache.misses() == 2);
+
+        // x, of max 10 (zigzag 20), given the value 11 (zigzag 22)
+        std::string outOfBounds = content;
+        const size_t value = outOfBounds.find(std::string("\x02\x14", 2));
+        REQUIRE(value != std::string::npos);
+        outOfBounds[value] = '\x16';
+        writeAtomically(image, outOfBounds);
+        CHECK(cache.load(json)->equals(*parsed));
+        CHECK(cache.misses() == 3);
+        CHECK(cache.load(json)->equals(*parsed));
+        CHECK(cache.hits() == 1);
+    }
+
+    SECTION("From a file")
+    {
+        const std::string path = directory.path_ + "/config.json";
+        std::ofstream(path) << json;
+        CHECK(cache.loadFile(path)->equals(*parsed));
+        CHECK(cache.hits() == 1);
+    }
+
+    SECTION("Unwritable image")
+    {
+        StartupCache unwritable(directory.path_ + "/missing/config.image");
+        CHECK(unwritable.load(json)->equals(*parsed));
+        CHECK(unwritable.load(json)->equals(*parsed));
+        CHECK(unwritable.misses() == 2);
+    }
+}
+}
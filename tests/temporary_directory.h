@@ -0,0 +1,24 @@
+#pragma once
+
+#include <catch2/catch.hpp>
+
+#include <stdlib.h>
+
+#include <string>
+
+namespace property
+{
+
+/// Temporary directory removed with its content at the end of the scope
+struct TemporaryDirectory {
+    TemporaryDirectory()
+    {
+        char pattern[] = "/tmp/properties.XXXXXX";
+        REQUIRE(::mkdtemp(pattern));
+        path_ = pattern;
+    }
+    ~TemporaryDirectory() { std::system(("rm -rf " + path_).c_str()); }
+
+    std::string path_;
+};
+}